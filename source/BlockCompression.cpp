@@ -0,0 +1,331 @@
+#include "pch.h"
+#include "BlockCompression.h"
+#include <cstring>
+
+namespace dae
+{
+	namespace BlockCompression
+	{
+		namespace
+		{
+			constexpr uint32_t PackRGBA(uint32_t r, uint32_t g, uint32_t b, uint32_t a)
+			{
+				return r | (g << 8) | (b << 16) | (a << 24);
+			}
+
+			constexpr uint32_t Channel(uint32_t texel, int channel)
+			{
+				return (texel >> (channel * 8)) & 0xFF;
+			}
+
+			uint16_t To565(uint32_t r, uint32_t g, uint32_t b)
+			{
+				return static_cast<uint16_t>(((r * 31 + 127) / 255) << 11 | ((g * 63 + 127) / 255) << 5 | ((b * 31 + 127) / 255));
+			}
+
+			void From565(uint16_t c, uint32_t& r, uint32_t& g, uint32_t& b)
+			{
+				//replicate the high bits into the low bits, same as the hardware expansion
+				r = (c >> 11) & 31; r = (r << 3) | (r >> 2);
+				g = (c >> 5) & 63;  g = (g << 2) | (g >> 4);
+				b = c & 31;         b = (b << 3) | (b >> 2);
+			}
+
+			//fetch the 16 texels of a block, edges are clamped for sizes that are not a multiple of 4
+			void GatherBlock(const uint32_t* pPixels, int width, int height, int pitchInPixels, int blockX, int blockY, uint32_t* pTexels)
+			{
+				for (int y{ 0 }; y < BlockSize; ++y)
+				{
+					const int py{ std::min(blockY * BlockSize + y, height - 1) };
+
+					for (int x{ 0 }; x < BlockSize; ++x)
+					{
+						const int px{ std::min(blockX * BlockSize + x, width - 1) };
+						pTexels[y * BlockSize + x] = pPixels[px + py * pitchInPixels];
+					}
+				}
+			}
+
+			//rgb endpoints on the bounding box diagonal, inset a bit to reduce the error of the extremes
+			void EncodeColorBlock(const uint32_t* pTexels, uint8_t* pBlock, bool allowThreeColorMode)
+			{
+				uint32_t minColor[3]{ 255, 255, 255 };
+				uint32_t maxColor[3]{ 0, 0, 0 };
+
+				for (int i{ 0 }; i < 16; ++i)
+				{
+					for (int c{ 0 }; c < 3; ++c)
+					{
+						minColor[c] = std::min(minColor[c], Channel(pTexels[i], c));
+						maxColor[c] = std::max(maxColor[c], Channel(pTexels[i], c));
+					}
+				}
+
+				for (int c{ 0 }; c < 3; ++c)
+				{
+					const uint32_t inset{ (maxColor[c] - minColor[c]) >> 4 };
+					minColor[c] += inset;
+					maxColor[c] -= inset;
+				}
+
+				uint16_t color0{ To565(maxColor[0], maxColor[1], maxColor[2]) };
+				uint16_t color1{ To565(minColor[0], minColor[1], minColor[2]) };
+
+				//color0 > color1 selects the 4 color mode, BC3 always decodes as 4 colors
+				if (color0 < color1) std::swap(color0, color1);
+
+				uint32_t palette[4][3]{};
+				From565(color0, palette[0][0], palette[0][1], palette[0][2]);
+				From565(color1, palette[1][0], palette[1][1], palette[1][2]);
+
+				for (int c{ 0 }; c < 3; ++c)
+				{
+					palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+					palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+				}
+
+				//a flat block leaves every index on color0
+				uint32_t indices{};
+
+				if (color0 != color1 || !allowThreeColorMode)
+				{
+					for (int i{ 0 }; i < 16; ++i)
+					{
+						uint32_t bestIndex{};
+						uint32_t bestError{ UINT32_MAX };
+
+						for (uint32_t p{ 0 }; p < 4; ++p)
+						{
+							uint32_t error{};
+							for (int c{ 0 }; c < 3; ++c)
+							{
+								const int diff{ static_cast<int>(Channel(pTexels[i], c)) - static_cast<int>(palette[p][c]) };
+								error += static_cast<uint32_t>(diff * diff);
+							}
+
+							if (error < bestError)
+							{
+								bestError = error;
+								bestIndex = p;
+							}
+						}
+
+						indices |= bestIndex << (i * 2);
+					}
+				}
+
+				std::memcpy(pBlock, &color0, 2);
+				std::memcpy(pBlock + 2, &color1, 2);
+				std::memcpy(pBlock + 4, &indices, 4);
+			}
+
+			//8 interpolated values between the min and max of one channel (BC4 layout)
+			void EncodeChannelBlock(const uint32_t* pTexels, int channel, uint8_t* pBlock)
+			{
+				uint32_t minValue{ 255 };
+				uint32_t maxValue{ 0 };
+
+				for (int i{ 0 }; i < 16; ++i)
+				{
+					minValue = std::min(minValue, Channel(pTexels[i], channel));
+					maxValue = std::max(maxValue, Channel(pTexels[i], channel));
+				}
+
+				pBlock[0] = static_cast<uint8_t>(maxValue);
+				pBlock[1] = static_cast<uint8_t>(minValue);
+
+				uint64_t indices{};
+
+				if (maxValue != minValue)
+				{
+					//the palette goes 0 = max, 1 = min, 2..7 = from max to min
+					constexpr uint64_t remap[8]{ 1, 7, 6, 5, 4, 3, 2, 0 };
+					const uint32_t range{ maxValue - minValue };
+
+					for (int i{ 0 }; i < 16; ++i)
+					{
+						const uint32_t value{ Channel(pTexels[i], channel) - minValue };
+						const uint32_t step{ (value * 7 + range / 2) / range };
+						indices |= remap[step] << (i * 3);
+					}
+				}
+
+				for (int b{ 0 }; b < 6; ++b)
+				{
+					pBlock[2 + b] = static_cast<uint8_t>(indices >> (b * 8));
+				}
+			}
+
+			void DecodeColorBlock(const uint8_t* pBlock, uint32_t* pTexels, bool allowThreeColorMode)
+			{
+				uint16_t color0{}, color1{};
+				uint32_t indices{};
+				std::memcpy(&color0, pBlock, 2);
+				std::memcpy(&color1, pBlock + 2, 2);
+				std::memcpy(&indices, pBlock + 4, 4);
+
+				uint32_t r0, g0, b0, r1, g1, b1;
+				From565(color0, r0, g0, b0);
+				From565(color1, r1, g1, b1);
+
+				uint32_t palette[4]{ PackRGBA(r0, g0, b0, 255), PackRGBA(r1, g1, b1, 255) };
+
+				if (color0 > color1 || !allowThreeColorMode)
+				{
+					palette[2] = PackRGBA((2 * r0 + r1) / 3, (2 * g0 + g1) / 3, (2 * b0 + b1) / 3, 255);
+					palette[3] = PackRGBA((r0 + 2 * r1) / 3, (g0 + 2 * g1) / 3, (b0 + 2 * b1) / 3, 255);
+				}
+				else
+				{
+					palette[2] = PackRGBA((r0 + r1) / 2, (g0 + g1) / 2, (b0 + b1) / 2, 255);
+					palette[3] = PackRGBA(0, 0, 0, 0);
+				}
+
+				for (int i{ 0 }; i < 16; ++i)
+				{
+					pTexels[i] = palette[(indices >> (i * 2)) & 3];
+				}
+			}
+
+			void DecodeChannelBlock(const uint8_t* pBlock, uint8_t* pValues)
+			{
+				const uint32_t value0{ pBlock[0] };
+				const uint32_t value1{ pBlock[1] };
+
+				uint32_t palette[8]{ value0, value1 };
+
+				if (value0 > value1)
+				{
+					for (uint32_t i{ 1 }; i < 7; ++i)
+					{
+						palette[i + 1] = ((7 - i) * value0 + i * value1) / 7;
+					}
+				}
+				else
+				{
+					for (uint32_t i{ 1 }; i < 5; ++i)
+					{
+						palette[i + 1] = ((5 - i) * value0 + i * value1) / 5;
+					}
+					palette[6] = 0;
+					palette[7] = 255;
+				}
+
+				uint64_t indices{};
+				for (int b{ 0 }; b < 6; ++b)
+				{
+					indices |= static_cast<uint64_t>(pBlock[2 + b]) << (b * 8);
+				}
+
+				for (int i{ 0 }; i < 16; ++i)
+				{
+					pValues[i] = static_cast<uint8_t>(palette[(indices >> (i * 3)) & 7]);
+				}
+			}
+		}
+
+		uint32_t GetBlockBytes(TextureFormat format)
+		{
+			switch (format)
+			{
+			case TextureFormat::BC1:
+				return 8;
+			case TextureFormat::BC3:
+			case TextureFormat::BC5:
+				return 16;
+			case TextureFormat::RGBA8:
+				break;
+			}
+
+			return 4 * BlockSize * BlockSize;
+		}
+
+		std::vector<uint8_t> Encode(TextureFormat format, const uint32_t* pPixels, int width, int height, int pitchInPixels)
+		{
+			const int blocksX{ (width + BlockSize - 1) / BlockSize };
+			const int blocksY{ (height + BlockSize - 1) / BlockSize };
+			const uint32_t blockBytes{ GetBlockBytes(format) };
+
+			std::vector<uint8_t> blocks(static_cast<size_t>(blocksX) * blocksY * blockBytes);
+
+			uint32_t texels[16]{};
+
+			for (int by{ 0 }; by < blocksY; ++by)
+			{
+				for (int bx{ 0 }; bx < blocksX; ++bx)
+				{
+					uint8_t* pBlock{ &blocks[(static_cast<size_t>(bx) + static_cast<size_t>(by) * blocksX) * blockBytes] };
+
+					GatherBlock(pPixels, width, height, pitchInPixels, bx, by, texels);
+
+					switch (format)
+					{
+					case TextureFormat::BC1:
+						EncodeColorBlock(texels, pBlock, true);
+						break;
+					case TextureFormat::BC3:
+						EncodeChannelBlock(texels, 3, pBlock);
+						EncodeColorBlock(texels, pBlock + 8, false);
+						break;
+					case TextureFormat::BC5:
+						EncodeChannelBlock(texels, 0, pBlock);
+						EncodeChannelBlock(texels, 1, pBlock + 8);
+						break;
+					case TextureFormat::RGBA8:
+						std::memcpy(pBlock, texels, sizeof(texels));
+						break;
+					}
+				}
+			}
+
+			return blocks;
+		}
+
+		void DecodeBlock(TextureFormat format, const uint8_t* pBlock, uint32_t* pTexels)
+		{
+			switch (format)
+			{
+			case TextureFormat::BC1:
+			{
+				DecodeColorBlock(pBlock, pTexels, true);
+			}
+			break;
+			case TextureFormat::BC3:
+			{
+				uint8_t alpha[16]{};
+				DecodeChannelBlock(pBlock, alpha);
+				DecodeColorBlock(pBlock + 8, pTexels, false);
+
+				for (int i{ 0 }; i < 16; ++i)
+				{
+					pTexels[i] = (pTexels[i] & 0x00FFFFFF) | (static_cast<uint32_t>(alpha[i]) << 24);
+				}
+			}
+			break;
+			case TextureFormat::BC5:
+			{
+				uint8_t red[16]{};
+				uint8_t green[16]{};
+				DecodeChannelBlock(pBlock, red);
+				DecodeChannelBlock(pBlock + 8, green);
+
+				for (int i{ 0 }; i < 16; ++i)
+				{
+					//reconstruct z of the unit normal and store it encoded in [0, 255] like the other channels
+					const float x{ red[i] / 127.5f - 1.f };
+					const float y{ green[i] / 127.5f - 1.f };
+					const float z{ std::sqrt(std::max(0.f, 1.f - x * x - y * y)) };
+
+					pTexels[i] = PackRGBA(red[i], green[i], static_cast<uint32_t>((z + 1.f) * 127.5f), 255);
+				}
+			}
+			break;
+			case TextureFormat::RGBA8:
+			{
+				std::memcpy(pTexels, pBlock, 16 * sizeof(uint32_t));
+			}
+			break;
+			}
+		}
+	}
+}
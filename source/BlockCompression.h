@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+namespace dae
+{
+	//storage format of the software copy of a texture
+	//the block layouts match DXGI_FORMAT_BC1/BC3/BC5_UNORM so the blocks can be uploaded to D3D as they are
+	enum class TextureFormat
+	{
+		RGBA8,
+		BC1, //rgb, 4 bits per texel (diffuse, specular, gloss)
+		BC3, //rgba, 8 bits per texel
+		BC5  //two channels, 8 bits per texel (tangent space normals, z is reconstructed)
+	};
+
+	namespace BlockCompression
+	{
+		static constexpr int BlockSize{ 4 };
+
+		//size in bytes of one 4x4 block
+		uint32_t GetBlockBytes(TextureFormat format);
+
+		//encodes a RGBA8 image (r in the lowest byte) into 4x4 blocks, rows are stored one after another
+		std::vector<uint8_t> Encode(TextureFormat format, const uint32_t* pPixels, int width, int height, int pitchInPixels);
+
+		//decodes one block into 16 RGBA8 texels (row major)
+		void DecodeBlock(TextureFormat format, const uint8_t* pBlock, uint32_t* pTexels);
+	}
+}
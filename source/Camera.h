@@ -38,6 +38,14 @@ namespace dae
 		Matrix invViewMatrix{};
 		Matrix viewMatrix{};
 		Matrix projectionMatrix{};
+		Matrix viewProjectionMatrix{};
+
+		//matrices are only rebuilt when their inputs changed
+		bool isViewDirty{ true };
+		bool isProjectionDirty{ true };
+
+		//bumped every time the matrices change, users compare it to the version they last saw
+		uint32_t version{};
 
 		const float sprintSpeedMultiplier{ 3 };
 
@@ -51,7 +59,25 @@ namespace dae
 
 			origin = _origin;
 
-			CalculateProjectionMatrix();
+			isViewDirty = true;
+			isProjectionDirty = true;
+
+			UpdateMatrices();
+		}
+
+		//recalculates the matrices whose inputs changed, view projection follows both
+		void UpdateMatrices()
+		{
+			if (!isViewDirty && !isProjectionDirty) return;
+
+			if (isViewDirty) CalculateViewMatrix();
+			if (isProjectionDirty) CalculateProjectionMatrix();
+
+			viewProjectionMatrix = viewMatrix * projectionMatrix;
+			++version;
+
+			isViewDirty = false;
+			isProjectionDirty = false;
 		}
 
 		void CalculateViewMatrix()
@@ -69,8 +95,8 @@ namespace dae
 				origin
 			};
 
-			//viewMatrix = invViewMatrix.Inverse();
-			viewMatrix = Matrix::Inverse(invViewMatrix);
+			//the camera axes are orthonormal, no need for the general inverse
+			viewMatrix = Matrix::InverseRigid(invViewMatrix);
 
 			//ViewMatrix => Matrix::CreateLookAtLH(...) [not implemented yet]
 			//DirectX Implementation => https://learn.microsoft.com/en-us/windows/win32/direct3d9/d3dxmatrixlookatlh
@@ -88,6 +114,10 @@ namespace dae
 		{
 			const float deltaTime = pTimer->GetElapsed();
 
+			const Vector3 previousOrigin{ origin };
+			const float previousPitch{ totalPitch };
+			const float previousYaw{ totalYaw };
+
 			const uint8_t* pKeyboardState = SDL_GetKeyboardState(nullptr);
 
 			int mouseX{}, mouseY{};
@@ -124,9 +154,16 @@ namespace dae
 			totalYaw += lmb * rotSpeed * fMouseX;
 			totalYaw += rmb * rotSpeed * fMouseX;
 
-			forward = (Matrix::CreateRotationX(totalPitch) * Matrix::CreateRotationY(totalYaw)).TransformVector(Vector3::UnitZ);
+			//only rebuild the rotation when the camera actually turned
+			if (totalPitch != previousPitch || totalYaw != previousYaw)
+			{
+				forward = (Matrix::CreateRotationX(totalPitch) * Matrix::CreateRotationY(totalYaw)).TransformVector(Vector3::UnitZ);
+				isViewDirty = true;
+			}
+
+			if (origin.x != previousOrigin.x || origin.y != previousOrigin.y || origin.z != previousOrigin.z) isViewDirty = true;
 
-			CalculateViewMatrix();
+			UpdateMatrices();
 		}
 	};
 }
\ No newline at end of file
@@ -14,16 +14,104 @@ namespace dae
 		Vector3 viewDirection{};
 	};
 
+	//quantized copy of a Vertex that is streamed every frame (20 bytes instead of 68)
+	//position: 16 bit unorm against the bounds of the mesh, w is padding (there is no 3 component 16 bit format)
+	//normal and tangent: octahedral encoded, 2 x 16 bit snorm
+	//uv: half floats
+	struct PackedVertex
+	{
+		uint16_t position[4]{};
+		int16_t normal[2]{};
+		int16_t tangent[2]{};
+		uint16_t uv[2]{};
+	};
+
+	static_assert(sizeof(PackedVertex) == 20);
+
+	//cluster of triangles that is culled as a whole
+	//the triangles are a range of the index buffer, the vertices a range of the vertex buffer only this meshlet uses
+	struct Meshlet
+	{
+		uint32_t triangleOffset{};
+		uint32_t triangleCount{};
+		uint32_t vertexOffset{};
+		uint32_t vertexCount{};
+
+		//bounding sphere in object space
+		Vector3 center{};
+		float radius{};
+
+		//normal cone, every triangle faces within the cone around the axis
+		//coneCutoff is the sine of the spread, 1 when the cone is too wide to cull anything
+		Vector3 coneAxis{};
+		float coneCutoff{ 1.f };
+	};
+
+	//level of detail of a mesh, a range of the index buffer that only uses its own range of the vertex buffer
+	struct MeshLod
+	{
+		uint32_t indexOffset{};
+		uint32_t indexCount{};
+		uint32_t vertexOffset{};
+		uint32_t vertexCount{};
+
+		//estimated distance (object space) between the simplified surface and the full detail one
+		float error{};
+	};
+
+	//one copy of a mesh in the scene, the vertex data is shared by all of them
+	struct MeshInstance
+	{
+		//placement of the instance, applied after the world matrix of the mesh
+		Matrix worldMatrix{};
+
+		//multiplied with the diffuse color
+		ColorRGB tint{ colors::White };
+
+		//lod picked last frame, the hysteresis of the selection depends on it
+		uint32_t lodIndex{};
+	};
+
+	//varyings interpolated across a triangle, only the ones in the active Varying set are filled
 	struct Vertex_Out
 	{
-		Vector4 position{};
 		Vector3 normal{};
 		Vector3 tangent{};
 		Vector2 uv{};
-		ColorRGB color{ colors::White };
 		Vector3 viewDirection{};
 	};
 
+	//projected vertex, x and y in raster space, z for the depth buffer and w for perspective correct interpolation
+	struct Vertex_Screen
+	{
+		Vector2 position{};
+		float z{};
+		float w{};
+	};
+
+	//set of varyings a shading mode reads, the rasterizer only carries and interpolates these
+	enum class Varying : uint8_t
+	{
+		None = 0,
+		Normal = 1 << 0,
+		Tangent = 1 << 1,
+		UV = 1 << 2,
+		ViewDirection = 1 << 3
+	};
+
+	//every combination of the flags above
+	constexpr size_t VaryingSetCount{ 16 };
+
+	constexpr Varying operator|(Varying a, Varying b)
+	{
+		return static_cast<Varying>(static_cast<uint8_t>(a) | static_cast<uint8_t>(b));
+	}
+
+	constexpr bool HasVarying(Varying set, Varying varying)
+	{
+		return (static_cast<uint8_t>(set) & static_cast<uint8_t>(varying)) != 0;
+	}
+
 	struct AABB
 	{
 		Vector2 minAABB{};
@@ -41,6 +41,21 @@ namespace dae
 			std::wcout << L"m_pMatInverseViewMatrixVariable not valid!\n";
 		}
 
+		//save the bounds the positions are quantized against
+		m_pPositionMinVariable = m_pEffect->GetVariableByName("gPositionMin")->AsVector();
+
+		if (!m_pPositionMinVariable->IsValid())
+		{
+			std::wcout << L"m_pPositionMinVariable not valid!\n";
+		}
+
+		m_pPositionExtentVariable = m_pEffect->GetVariableByName("gPositionExtent")->AsVector();
+
+		if (!m_pPositionExtentVariable->IsValid())
+		{
+			std::wcout << L"m_pPositionExtentVariable not valid!\n";
+		}
+
 		//save diffuse
 		m_pDiffuseMapVariable = m_pEffect->GetVariableByName("gDiffuseMap")->AsShaderResource();
 
@@ -215,6 +230,12 @@ namespace dae
 		m_pMatInverseViewMatrixVariable->SetMatrix(reinterpret_cast<const float*>(&invViewMatrix));
 	}
 
+	void Effect::SetPositionBounds(const Vector3& min, const Vector3& extent) const
+	{
+		m_pPositionMinVariable->SetFloatVector(reinterpret_cast<const float*>(&min));
+		m_pPositionExtentVariable->SetFloatVector(reinterpret_cast<const float*>(&extent));
+	}
+
 	void Effect::SetDiffuseMap(const Texture* pTexture) const
 	{
 
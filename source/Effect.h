@@ -50,6 +50,9 @@ namespace dae
 
 			void SetWorldMatrix(const Matrix& worldMatrix) const;
 
+			//positions are stored as unorm against this box, the vertex shader decodes them with it
+			void SetPositionBounds(const Vector3& min, const Vector3& extent) const;
+
 
 			void SetDiffuseMap(const Texture* pTexture) const;
 
@@ -164,6 +167,9 @@ namespace dae
 			ID3DX11EffectMatrixVariable* m_pMatWorldMatrixVariable{};
 			ID3DX11EffectMatrixVariable* m_pMatInverseViewMatrixVariable{};
 
+			ID3DX11EffectVectorVariable* m_pPositionMinVariable{};
+			ID3DX11EffectVectorVariable* m_pPositionExtentVariable{};
+
 			ID3DX11EffectShaderResourceVariable* m_pDiffuseMapVariable{};
 
 			ID3DX11EffectSamplerVariable* m_pEffectSamplerVariable{};
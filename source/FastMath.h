@@ -0,0 +1,82 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <xmmintrin.h>
+#include "Vector3.h"
+
+namespace dae
+{
+	//exact uses the standard library, fast uses the approximations below
+	enum class MathQuality
+	{
+		Exact,
+		Fast
+	};
+
+	//branch free approximations for the per pixel shading, plain float math so loops over them can vectorize
+	namespace FastMath
+	{
+		//1 / sqrt(x), hardware estimate (12 bits) refined with one newton step (~22 bits)
+		inline float Rsqrt(float x)
+		{
+			const float estimate{ _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x))) };
+
+			return estimate * (1.5f - 0.5f * x * estimate * estimate);
+		}
+
+		//1 / x, hardware estimate (12 bits) refined with one newton step (~22 bits)
+		inline float Reciprocal(float x)
+		{
+			const float estimate{ _mm_cvtss_f32(_mm_rcp_ss(_mm_set_ss(x))) };
+
+			return estimate * (2.f - x * estimate);
+		}
+
+		//log2 of a positive normal float, absolute error ~2e-6
+		inline float Log2(float x)
+		{
+			const uint32_t bits{ std::bit_cast<uint32_t>(x) };
+
+			//split into exponent and mantissa in [1, 2)
+			const float exponent{ static_cast<float>(static_cast<int>(bits >> 23) - 127) };
+			const float m{ std::bit_cast<float>((bits & 0x007FFFFF) | 0x3F800000) - 1.f };
+
+			//least squares fit of log2(1 + m) on [0, 1]
+			const float p{ 2.1237387e-6f + m * (1.4424753f + m * (-0.7175579f + m * (0.4555271f + m * (-0.2746233f + m * (0.1192982f + m * -0.0251232f))))) };
+
+			return exponent + p;
+		}
+
+		//2^x, relative error ~1e-7, clamped to the normal float range
+		inline float Exp2(float x)
+		{
+			x = std::clamp(x, -126.f, 127.f);
+
+			const float whole{ std::floor(x) };
+			const float f{ x - whole };
+
+			//least squares fit of 2^f on [0, 1]
+			const float p{ 0.9999999f + f * (0.6931546f + f * (0.2401408f + f * (0.0558633f + f * (0.0089462f + f * 0.0018951f)))) };
+
+			//add the whole part straight into the exponent bits
+			const uint32_t scale{ static_cast<uint32_t>(static_cast<int>(whole) + 127) << 23 };
+
+			return p * std::bit_cast<float>(scale);
+		}
+
+		//x^y for x >= 0, 0 for x <= 0 (like powf for the positive exponents of the phong term)
+		inline float Pow(float x, float y)
+		{
+			if (x <= 0.f) return y == 0.f ? 1.f : 0.f;
+
+			return Exp2(y * Log2(x));
+		}
+
+		inline Vector3 Normalized(const Vector3& v)
+		{
+			return v * Rsqrt(v.SqrMagnitude());
+		}
+	}
+}
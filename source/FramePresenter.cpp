@@ -0,0 +1,282 @@
+#include "pch.h"
+#include "FramePresenter.h"
+
+namespace dae
+{
+	FramePresenter::FramePresenter(SDL_Window* pWindow, int width, int height, int nrOfBackBuffers, PresentMode mode) :
+		m_pWindow(pWindow),
+		m_WindowFormat(SDL_GetWindowSurface(pWindow)->format->format),
+		m_Width(width),
+		m_Height(height),
+		m_Mode(mode)
+	{
+		CreateBuffers(nrOfBackBuffers);
+
+		m_Thread = std::thread{ &FramePresenter::ConvertLoop, this };
+	}
+
+	FramePresenter::~FramePresenter()
+	{
+		//the queued frames are still shown before the thread stops
+		Flush();
+
+		{
+			const std::lock_guard lock{ m_Mutex };
+			m_IsRunning = false;
+		}
+
+		m_Changed.notify_all();
+		m_Thread.join();
+
+		FreeBuffers();
+	}
+
+	void FramePresenter::CreateBuffers(int nrOfBackBuffers)
+	{
+		m_BackBuffers.resize(std::clamp(nrOfBackBuffers, 2, 3));
+		m_FrontBuffers.resize(m_BackBuffers.size());
+
+		for (BackBuffer& backBuffer : m_BackBuffers)
+		{
+			backBuffer.pSurface = SDL_CreateRGBSurface(0, m_Width, m_Height, 32, 0, 0, 0, 0);
+		}
+
+		//in the format of the window, showing them is a plain copy
+		for (FrontBuffer& frontBuffer : m_FrontBuffers)
+		{
+			frontBuffer.pSurface = SDL_CreateRGBSurfaceWithFormat(0, m_Width, m_Height, SDL_BITSPERPIXEL(m_WindowFormat), m_WindowFormat);
+		}
+	}
+
+	void FramePresenter::FreeBuffers()
+	{
+		for (const BackBuffer& backBuffer : m_BackBuffers)
+		{
+			SDL_FreeSurface(backBuffer.pSurface);
+		}
+
+		for (const FrontBuffer& frontBuffer : m_FrontBuffers)
+		{
+			SDL_FreeSurface(frontBuffer.pSurface);
+		}
+
+		m_BackBuffers.clear();
+		m_FrontBuffers.clear();
+		m_ReadyFrames.clear();
+	}
+
+	SDL_Surface* FramePresenter::AcquireBackBuffer()
+	{
+		//the frame finished since the last call
+		ShowReadyFrame();
+
+		std::unique_lock lock{ m_Mutex };
+
+		const auto isFree = [](const BackBuffer& backBuffer) { return !backBuffer.isBusy; };
+
+		while (true)
+		{
+			m_Changed.wait(lock, [&]() { return std::any_of(m_BackBuffers.begin(), m_BackBuffers.end(), isFree) || !m_ReadyFrames.empty(); });
+
+			const auto it{ std::find_if(m_BackBuffers.begin(), m_BackBuffers.end(), isFree) };
+
+			if (it != m_BackBuffers.end()) return it->pSurface;
+
+			//every back buffer waits for a front buffer, only showing a frame frees one
+			lock.unlock();
+			ShowReadyFrame();
+			lock.lock();
+		}
+	}
+
+	void FramePresenter::Present(SDL_Surface* pBackBuffer)
+	{
+		{
+			const std::lock_guard lock{ m_Mutex };
+
+			const size_t backBufferIndex{ static_cast<size_t>(std::find_if(m_BackBuffers.begin(), m_BackBuffers.end(), [&](const BackBuffer& backBuffer) { return backBuffer.pSurface == pBackBuffer; }) - m_BackBuffers.begin()) };
+
+			//the frames nobody saw yet are outdated, their buffers are free again
+			if (m_Mode == PresentMode::Latest)
+			{
+				for (const size_t queued : m_Queue)
+				{
+					m_BackBuffers[queued].isBusy = false;
+					++m_NrOfDropped;
+				}
+
+				m_Queue.clear();
+			}
+
+			m_BackBuffers[backBufferIndex].isBusy = true;
+			m_Queue.push_back(backBufferIndex);
+		}
+
+		m_Changed.notify_all();
+	}
+
+	void FramePresenter::Flush()
+	{
+		const auto isConverted = [&]()
+		{
+			return m_Queue.empty() && std::none_of(m_FrontBuffers.begin(), m_FrontBuffers.end(), [](const FrontBuffer& frontBuffer) { return frontBuffer.state == FrontBuffer::State::Converting; });
+		};
+
+		while (true)
+		{
+			//fifo shows every frame in order, latest only the newest one
+			if (ShowReadyFrame()) continue;
+
+			std::unique_lock lock{ m_Mutex };
+
+			if (isConverted() && m_ReadyFrames.empty()) return;
+
+			m_Changed.wait(lock, [&]() { return isConverted() || !m_ReadyFrames.empty(); });
+		}
+	}
+
+	void FramePresenter::SetNrOfBackBuffers(int nrOfBackBuffers)
+	{
+		Flush();
+
+		const std::lock_guard lock{ m_Mutex };
+
+		FreeBuffers();
+		CreateBuffers(nrOfBackBuffers);
+	}
+
+	void FramePresenter::SetPresentMode(PresentMode mode)
+	{
+		{
+			const std::lock_guard lock{ m_Mutex };
+			m_Mode = mode;
+		}
+
+		//latest lets the thread replace a ready frame it was waiting on
+		m_Changed.notify_all();
+	}
+
+	void FramePresenter::ResetStatistics(uint32_t& nrOfShown, uint32_t& nrOfDropped)
+	{
+		const std::lock_guard lock{ m_Mutex };
+
+		nrOfShown = m_NrOfShown;
+		nrOfDropped = m_NrOfDropped;
+
+		m_NrOfShown = 0;
+		m_NrOfDropped = 0;
+	}
+
+	bool FramePresenter::ShowReadyFrame()
+	{
+		std::unique_lock lock{ m_Mutex };
+
+		if (m_ReadyFrames.empty()) return false;
+
+		size_t frontBufferIndex{};
+
+		if (m_Mode == PresentMode::Latest)
+		{
+			//only the newest one is shown, the older ones are outdated
+			frontBufferIndex = m_ReadyFrames.back();
+			m_ReadyFrames.pop_back();
+
+			for (const size_t ready : m_ReadyFrames)
+			{
+				m_FrontBuffers[ready].state = FrontBuffer::State::Free;
+				++m_NrOfDropped;
+			}
+
+			m_ReadyFrames.clear();
+		}
+		else
+		{
+			frontBufferIndex = m_ReadyFrames.front();
+			m_ReadyFrames.pop_front();
+		}
+
+		FrontBuffer& frontBuffer{ m_FrontBuffers[frontBufferIndex] };
+		frontBuffer.state = FrontBuffer::State::Showing;
+
+		//the copy and the window update run without the lock, the thread keeps converting meanwhile
+		lock.unlock();
+
+		//fetched every time, polling the events can recreate the window surface
+		SDL_Surface* pWindowSurface{ SDL_GetWindowSurface(m_pWindow) };
+
+		if (pWindowSurface != nullptr)
+		{
+			SDL_BlitSurface(frontBuffer.pSurface, nullptr, pWindowSurface, nullptr);
+			SDL_UpdateWindowSurface(m_pWindow);
+		}
+
+		lock.lock();
+
+		frontBuffer.state = FrontBuffer::State::Free;
+		++m_NrOfShown;
+
+		lock.unlock();
+		m_Changed.notify_all();
+
+		return true;
+	}
+
+	void FramePresenter::ConvertLoop()
+	{
+		std::unique_lock lock{ m_Mutex };
+
+		const auto findFreeFrontBuffer = [&]()
+		{
+			return std::find_if(m_FrontBuffers.begin(), m_FrontBuffers.end(), [](const FrontBuffer& frontBuffer) { return frontBuffer.state == FrontBuffer::State::Free; });
+		};
+
+		while (true)
+		{
+			//fifo waits for the main thread to show a frame when every front buffer is ready, latest replaces the oldest one
+			m_Changed.wait(lock, [&]()
+			{
+				if (m_Queue.empty()) return !m_IsRunning;
+
+				return findFreeFrontBuffer() != m_FrontBuffers.end() || (m_Mode == PresentMode::Latest && !m_ReadyFrames.empty());
+			});
+
+			if (m_Queue.empty()) return;
+
+			const size_t backBufferIndex{ m_Queue.front() };
+			m_Queue.pop_front();
+
+			size_t frontBufferIndex{};
+
+			if (const auto it{ findFreeFrontBuffer() }; it != m_FrontBuffers.end())
+			{
+				frontBufferIndex = static_cast<size_t>(it - m_FrontBuffers.begin());
+			}
+			else
+			{
+				frontBufferIndex = m_ReadyFrames.front();
+				m_ReadyFrames.pop_front();
+				++m_NrOfDropped;
+			}
+
+			const BackBuffer& backBuffer{ m_BackBuffers[backBufferIndex] };
+			FrontBuffer& frontBuffer{ m_FrontBuffers[frontBufferIndex] };
+
+			frontBuffer.state = FrontBuffer::State::Converting;
+
+			//the conversion runs without the lock, the renderer keeps drawing into a free buffer
+			//the back buffer stays busy, so it is neither handed out nor recreated meanwhile
+			lock.unlock();
+
+			SDL_ConvertPixels(m_Width, m_Height, backBuffer.pSurface->format->format, backBuffer.pSurface->pixels, backBuffer.pSurface->pitch,
+				frontBuffer.pSurface->format->format, frontBuffer.pSurface->pixels, frontBuffer.pSurface->pitch);
+
+			lock.lock();
+
+			m_BackBuffers[backBufferIndex].isBusy = false;
+			frontBuffer.state = FrontBuffer::State::Ready;
+			m_ReadyFrames.push_back(frontBufferIndex);
+
+			m_Changed.notify_all();
+		}
+	}
+}
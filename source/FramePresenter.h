@@ -0,0 +1,119 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct SDL_Window;
+struct SDL_Surface;
+
+namespace dae
+{
+	//hands the software frames to the window, the renderer draws the next frame into a free back buffer meanwhile
+	//a thread of its own converts the drawn back buffers to the format of the window, it never touches the window
+	//the window calls (SDL video) only run on the main thread, in AcquireBackBuffer and Flush
+	class FramePresenter final
+	{
+	public:
+
+		enum class PresentMode
+		{
+			//every frame is shown in order, the renderer waits when all back buffers are queued
+			Fifo,
+			//a new frame replaces the queued ones that were not shown yet, the renderer never waits with 3 buffers
+			Latest
+		};
+
+		FramePresenter(SDL_Window* pWindow, int width, int height, int nrOfBackBuffers = 2, PresentMode mode = PresentMode::Fifo);
+		~FramePresenter();
+
+		FramePresenter(const FramePresenter&) = delete;
+		FramePresenter(FramePresenter&&) noexcept = delete;
+		FramePresenter& operator=(const FramePresenter&) = delete;
+		FramePresenter& operator=(FramePresenter&&) noexcept = delete;
+
+		//shows the converted frame that is next in line, then returns a back buffer that is neither queued nor being converted
+		//waits for one when all of them are (the back pressure on the renderer), main thread only
+		SDL_Surface* AcquireBackBuffer();
+
+		//queues the drawn back buffer for the conversion and returns right away
+		void Present(SDL_Surface* pBackBuffer);
+
+		//waits for the queued conversions and shows them, main thread only
+		void Flush();
+
+		//2 or 3, flushes and recreates the back buffers
+		void SetNrOfBackBuffers(int nrOfBackBuffers);
+		int GetNrOfBackBuffers() const { return static_cast<int>(m_BackBuffers.size()); }
+
+		void SetPresentMode(PresentMode mode);
+		PresentMode GetPresentMode() const { return m_Mode; }
+
+		//frames shown and frames replaced before they were shown since the last call
+		void ResetStatistics(uint32_t& nrOfShown, uint32_t& nrOfDropped);
+
+	private:
+
+		struct BackBuffer
+		{
+			SDL_Surface* pSurface{};
+
+			//queued or being converted
+			bool isBusy{};
+		};
+
+		//a back buffer converted to the format of the window, waiting to be shown
+		struct FrontBuffer
+		{
+			enum class State
+			{
+				Free,
+				Converting,
+				Ready,
+				Showing
+			};
+
+			SDL_Surface* pSurface{};
+			State state{ State::Free };
+		};
+
+		SDL_Window* m_pWindow{};
+
+		//pixel format of the window surface, read on the main thread when the presenter is created
+		uint32_t m_WindowFormat{};
+
+		int m_Width{};
+		int m_Height{};
+
+		std::vector<BackBuffer> m_BackBuffers{};
+		std::vector<FrontBuffer> m_FrontBuffers{};
+		PresentMode m_Mode{};
+
+		std::mutex m_Mutex{};
+		std::condition_variable m_Changed{};
+
+		//indices of the back buffers waiting to be converted, oldest first
+		std::deque<size_t> m_Queue{};
+
+		//indices of the converted front buffers waiting to be shown, oldest first
+		std::deque<size_t> m_ReadyFrames{};
+
+		bool m_IsRunning{ true };
+
+		uint32_t m_NrOfShown{};
+		uint32_t m_NrOfDropped{};
+
+		std::thread m_Thread{};
+
+		void CreateBuffers(int nrOfBackBuffers);
+		void FreeBuffers();
+
+		//copies the next ready frame to the window surface and updates the window, false when none was ready
+		//main thread only, the window surface can change with every event the main thread polls
+		bool ShowReadyFrame();
+
+		void ConvertLoop();
+	};
+}
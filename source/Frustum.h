@@ -0,0 +1,72 @@
+#pragma once
+#include "Matrix.h"
+#include "Vector3.h"
+#include "Vector4.h"
+
+namespace dae
+{
+	//the 6 planes of a view frustum, normals point inside
+	struct Frustum
+	{
+		//xyz is the normal, w the distance, a point p is inside when Dot(normal, p) + w >= 0
+		Vector4 planes[6]{};
+
+		//planes of a (world) view projection matrix, in the space the matrix transforms from (D3D clip space, 0 <= z <= w)
+		static Frustum FromMatrix(const Matrix& m)
+		{
+			const auto column = [&m](int idx) { return Vector4{ m[0][idx], m[1][idx], m[2][idx], m[3][idx] }; };
+
+			const Vector4 x{ column(0) };
+			const Vector4 y{ column(1) };
+			const Vector4 z{ column(2) };
+			const Vector4 w{ column(3) };
+
+			Frustum frustum{ { w + x, w - x, w + y, w - y, z, w - z } };
+
+			//normalized so the distances can be compared with radii
+			for (Vector4& plane : frustum.planes)
+			{
+				plane = plane * (1.f / Vector3{ plane.x, plane.y, plane.z }.Magnitude());
+			}
+
+			return frustum;
+		}
+
+		bool IsSphereOutside(const Vector3& center, float radius) const
+		{
+			for (const Vector4& plane : planes)
+			{
+				if (plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w < -radius) return true;
+			}
+
+			return false;
+		}
+
+		//axis aligned box in the space of the planes, outside when all corners are behind one plane
+		bool IsBoxOutside(const Vector3& min, const Vector3& max) const
+		{
+			for (const Vector4& plane : planes)
+			{
+				//the corner furthest along the normal
+				const Vector3 corner{ plane.x >= 0.f ? max.x : min.x, plane.y >= 0.f ? max.y : min.y, plane.z >= 0.f ? max.z : min.z };
+
+				if (plane.x * corner.x + plane.y * corner.y + plane.z * corner.z + plane.w < 0.f) return true;
+			}
+
+			return false;
+		}
+
+		//inside when the corner nearest to every plane is still in front of it
+		bool IsBoxInside(const Vector3& min, const Vector3& max) const
+		{
+			for (const Vector4& plane : planes)
+			{
+				const Vector3 corner{ plane.x >= 0.f ? min.x : max.x, plane.y >= 0.f ? min.y : max.y, plane.z >= 0.f ? min.z : max.z };
+
+				if (plane.x * corner.x + plane.y * corner.y + plane.z * corner.z + plane.w < 0.f) return false;
+			}
+
+			return true;
+		}
+	};
+}
@@ -0,0 +1,156 @@
+#include "pch.h"
+#include "JobSystem.h"
+
+namespace dae
+{
+	thread_local uint32_t JobSystem::m_ThreadIndex{};
+
+	JobSystem::JobSystem()
+	{
+		//the main thread is the last worker, it runs jobs while it waits
+		const unsigned int nrOfThreads{ std::max(std::thread::hardware_concurrency(), 1u) };
+
+		for (unsigned int idx{}; idx < nrOfThreads; ++idx)
+		{
+			m_Queues.emplace_back(std::make_unique<Queue>());
+		}
+
+		for (uint32_t threadIndex{ 1 }; threadIndex < nrOfThreads; ++threadIndex)
+		{
+			m_Workers.emplace_back(&JobSystem::WorkerLoop, this, threadIndex);
+		}
+	}
+
+	JobSystem::~JobSystem()
+	{
+		{
+			const std::lock_guard lock{ m_SleepMutex };
+			m_IsRunning = false;
+		}
+
+		m_WakeUp.notify_all();
+
+		for (std::thread& worker : m_Workers)
+		{
+			worker.join();
+		}
+	}
+
+	JobSystem& JobSystem::GetInstance()
+	{
+		//the workers start with the first job and stop when the program exits
+		static JobSystem instance{};
+		return instance;
+	}
+
+	void JobSystem::Run(JobCounter& counter, std::function<void()> job, const char* pName)
+	{
+		counter.m_NrOfPending.fetch_add(1, std::memory_order_relaxed);
+
+		GetInstance().Push(Job{ std::move(job), &counter, pName });
+	}
+
+	void JobSystem::Wait(const JobCounter& counter)
+	{
+		JobSystem& instance{ GetInstance() };
+
+		while (!counter.IsDone())
+		{
+			if (!instance.TryRunJob()) std::this_thread::yield();
+		}
+	}
+
+	void JobSystem::Push(Job job)
+	{
+		Queue& queue{ *m_Queues[m_ThreadIndex] };
+
+		{
+			const std::lock_guard lock{ queue.mutex };
+			queue.jobs.push_back(std::move(job));
+		}
+
+		//a worker counts itself as sleeping before it checks the job count, both are sequentially consistent
+		//so either the worker sees the job or the count of sleeping workers is seen here
+		m_NrOfQueuedJobs.fetch_add(1, std::memory_order_seq_cst);
+
+		//busy workers find the job themselves
+		if (m_NrOfSleeping.load(std::memory_order_seq_cst) == 0) return;
+
+		//taking the lock waits for a worker that checked the job count but is not waiting yet, so the wake up is never lost
+		{
+			const std::lock_guard lock{ m_SleepMutex };
+		}
+
+		m_WakeUp.notify_one();
+	}
+
+	bool JobSystem::TryRunJob()
+	{
+		const uint32_t nrOfQueues{ static_cast<uint32_t>(m_Queues.size()) };
+
+		Job job{};
+		bool isFound{ false };
+
+		for (uint32_t offset{}; offset < nrOfQueues && !isFound; ++offset)
+		{
+			Queue& queue{ *m_Queues[(m_ThreadIndex + offset) % nrOfQueues] };
+
+			const std::lock_guard lock{ queue.mutex };
+
+			if (queue.jobs.empty()) continue;
+
+			//the newest job of the own queue is still warm in the cache, steal the oldest one of the others, it tends to be the biggest
+			if (offset == 0)
+			{
+				job = std::move(queue.jobs.back());
+				queue.jobs.pop_back();
+			}
+			else
+			{
+				job = std::move(queue.jobs.front());
+				queue.jobs.pop_front();
+			}
+
+			isFound = true;
+		}
+
+		if (!isFound) return false;
+
+		m_NrOfQueuedJobs.fetch_sub(1, std::memory_order_relaxed);
+
+		const TimingHook pTimingHook{ m_pTimingHook.load(std::memory_order_acquire) };
+
+		if (pTimingHook)
+		{
+			const auto start{ std::chrono::steady_clock::now() };
+
+			job.function();
+
+			pTimingHook(JobTiming{ job.pName, m_ThreadIndex, start, std::chrono::steady_clock::now() });
+		}
+		else
+		{
+			job.function();
+		}
+
+		job.pCounter->m_NrOfPending.fetch_sub(1, std::memory_order_release);
+
+		return true;
+	}
+
+	void JobSystem::WorkerLoop(uint32_t threadIndex)
+	{
+		m_ThreadIndex = threadIndex;
+
+		while (m_IsRunning)
+		{
+			if (TryRunJob()) continue;
+
+			std::unique_lock lock{ m_SleepMutex };
+
+			m_NrOfSleeping.fetch_add(1, std::memory_order_seq_cst);
+			m_WakeUp.wait(lock, [this]() { return !m_IsRunning || m_NrOfQueuedJobs.load(std::memory_order_seq_cst) > 0; });
+			m_NrOfSleeping.fetch_sub(1, std::memory_order_relaxed);
+		}
+	}
+}
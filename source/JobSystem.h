@@ -0,0 +1,138 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dae
+{
+	//number of jobs of a group that have not finished yet, JobSystem::Wait returns once it is back at zero
+	//a job can start children on the counter of its own group, the wait on the parent then covers the children as well
+	class JobCounter final
+	{
+	public:
+
+		bool IsDone() const { return m_NrOfPending.load(std::memory_order_acquire) == 0; }
+
+	private:
+
+		friend class JobSystem;
+
+		std::atomic<uint32_t> m_NrOfPending{};
+	};
+
+	//one finished job, handed to the timing hook
+	struct JobTiming
+	{
+		const char* pName{};
+
+		//0 for a thread outside of the workers, the main thread helping out while it waits
+		uint32_t threadIndex{};
+
+		std::chrono::steady_clock::time_point start{};
+		std::chrono::steady_clock::time_point end{};
+	};
+
+	//work stealing scheduler shared by the loading and every stage of the renderer
+	//every thread has its own deque, it takes its newest job first and steals the oldest one of another thread when it runs dry
+	//a thread waiting on a counter runs jobs instead of sleeping, so a job can wait on its own children
+	class JobSystem final
+	{
+	public:
+
+		//a plain function, a job that loaded the hook just before it was changed still calls the old one
+		using TimingHook = void(*)(const JobTiming& timing);
+
+		//queues the job, counter counts it until it returned
+		static void Run(JobCounter& counter, std::function<void()> job, const char* pName = "job");
+
+		//runs queued jobs on the calling thread until the counter is done
+		static void Wait(const JobCounter& counter);
+
+		//calls function(begin, end) on the chunks of [0, count), the calling thread takes the first chunk and helps with the rest
+		template<typename Function>
+		static void ParallelFor(size_t count, size_t chunkSize, Function function, const char* pName = "parallel for");
+
+		//workers plus the thread that waits
+		static unsigned int GetNrOfThreads() { return static_cast<unsigned int>(GetInstance().m_Queues.size()); }
+
+		//called on the thread that ran the job, after every job, can be changed while jobs run
+		static void SetTimingHook(TimingHook pHook) { GetInstance().m_pTimingHook.store(pHook, std::memory_order_release); }
+
+	private:
+
+		struct Job
+		{
+			std::function<void()> function{};
+			JobCounter* pCounter{};
+			const char* pName{};
+		};
+
+		struct Queue
+		{
+			std::mutex mutex{};
+			std::deque<Job> jobs{};
+		};
+
+		JobSystem();
+		~JobSystem();
+
+		JobSystem(const JobSystem&) = delete;
+		JobSystem(JobSystem&&) noexcept = delete;
+		JobSystem& operator=(const JobSystem&) = delete;
+		JobSystem& operator=(JobSystem&&) noexcept = delete;
+
+		static JobSystem& GetInstance();
+
+		//the first queue belongs to every thread that is not a worker
+		std::vector<std::unique_ptr<Queue>> m_Queues{};
+		std::vector<std::thread> m_Workers{};
+
+		//sleeping workers are woken when a job is queued, pushing only takes the lock while one of them sleeps
+		std::atomic<uint32_t> m_NrOfQueuedJobs{};
+		std::atomic<uint32_t> m_NrOfSleeping{};
+		std::atomic<bool> m_IsRunning{ true };
+		std::mutex m_SleepMutex{};
+		std::condition_variable m_WakeUp{};
+
+		std::atomic<TimingHook> m_pTimingHook{};
+
+		static thread_local uint32_t m_ThreadIndex;
+
+		void Push(Job job);
+
+		//own queue first, then the other queues, false when every queue was empty
+		bool TryRunJob();
+
+		void WorkerLoop(uint32_t threadIndex);
+	};
+
+	template<typename Function>
+	void JobSystem::ParallelFor(size_t count, size_t chunkSize, Function function, const char* pName)
+	{
+		if (chunkSize == 0 || count <= chunkSize)
+		{
+			function(size_t{ 0 }, count);
+			return;
+		}
+
+		JobCounter counter{};
+
+		for (size_t begin{ chunkSize }; begin < count; begin += chunkSize)
+		{
+			const size_t end{ std::min(begin + chunkSize, count) };
+
+			Run(counter, [&function, begin, end]() { function(begin, end); }, pName);
+		}
+
+		function(size_t{ 0 }, chunkSize);
+
+		Wait(counter);
+	}
+}
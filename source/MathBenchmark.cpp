@@ -0,0 +1,278 @@
+#include "pch.h"
+#include "MathBenchmark.h"
+#include "PixelOutput.h"
+#include "Texture.h"
+#include <iomanip>
+#include <thread>
+
+namespace dae
+{
+	namespace MathBenchmark
+	{
+		namespace
+		{
+			constexpr int nrOfElements{ 4096 };
+			constexpr int nrOfIterations{ 256 };
+
+			//scalar reference versions, the way Matrix was implemented before the sse backend
+			//noinline because they used to live out of line in Matrix.cpp
+			struct ScalarMatrix
+			{
+				float m[4][4];
+			};
+
+			ScalarMatrix ToScalar(const Matrix& matrix)
+			{
+				ScalarMatrix result{};
+
+				for (int r{ 0 }; r < 4; ++r)
+				{
+					for (int c{ 0 }; c < 4; ++c)
+					{
+						result.m[r][c] = matrix[r][c];
+					}
+				}
+
+				return result;
+			}
+
+			__declspec(noinline) Vector3 ScalarTransformPoint(const ScalarMatrix& s, const Vector3& p)
+			{
+				return Vector3{
+					s.m[0][0] * p.x + s.m[1][0] * p.y + s.m[2][0] * p.z + s.m[3][0],
+					s.m[0][1] * p.x + s.m[1][1] * p.y + s.m[2][1] * p.z + s.m[3][1],
+					s.m[0][2] * p.x + s.m[1][2] * p.y + s.m[2][2] * p.z + s.m[3][2]
+				};
+			}
+
+			__declspec(noinline) Vector3 ScalarTransformVector(const ScalarMatrix& s, const Vector3& v)
+			{
+				return Vector3{
+					s.m[0][0] * v.x + s.m[1][0] * v.y + s.m[2][0] * v.z,
+					s.m[0][1] * v.x + s.m[1][1] * v.y + s.m[2][1] * v.z,
+					s.m[0][2] * v.x + s.m[1][2] * v.y + s.m[2][2] * v.z
+				};
+			}
+
+			__declspec(noinline) Vector4 ScalarTransformPoint4(const ScalarMatrix& s, const Vector4& p)
+			{
+				Vector4 result{};
+
+				for (int c{ 0 }; c < 4; ++c)
+				{
+					result[c] = s.m[0][c] * p.x + s.m[1][c] * p.y + s.m[2][c] * p.z + s.m[3][c];
+				}
+
+				return result;
+			}
+
+			__declspec(noinline) ScalarMatrix ScalarMultiply(const ScalarMatrix& a, const ScalarMatrix& b)
+			{
+				//dot of the rows with the transposed columns
+				ScalarMatrix transposed{};
+
+				for (int r{ 0 }; r < 4; ++r)
+				{
+					for (int c{ 0 }; c < 4; ++c)
+					{
+						transposed.m[r][c] = b.m[c][r];
+					}
+				}
+
+				ScalarMatrix result{};
+
+				for (int r{ 0 }; r < 4; ++r)
+				{
+					for (int c{ 0 }; c < 4; ++c)
+					{
+						result.m[r][c] = a.m[r][0] * transposed.m[c][0] + a.m[r][1] * transposed.m[c][1] + a.m[r][2] * transposed.m[c][2] + a.m[r][3] * transposed.m[c][3];
+					}
+				}
+
+				return result;
+			}
+
+			__declspec(noinline) Vector4 ScalarAdd(const Vector4& v1, const Vector4& v2)
+			{
+				return Vector4{ v1.x + v2.x, v1.y + v2.y, v1.z + v2.z, v1.w + v2.w };
+			}
+
+			//keeps the results alive so the loops are not optimized away
+			volatile float g_Sink{};
+
+			template<typename Function>
+			double MeasureNanoseconds(Function function)
+			{
+				const uint64_t start{ SDL_GetPerformanceCounter() };
+
+				for (int iteration{ 0 }; iteration < nrOfIterations; ++iteration)
+				{
+					function();
+				}
+
+				const uint64_t elapsed{ SDL_GetPerformanceCounter() - start };
+
+				return static_cast<double>(elapsed) * 1e9 / static_cast<double>(SDL_GetPerformanceFrequency()) / (static_cast<double>(nrOfIterations) * nrOfElements);
+			}
+
+			void PrintResult(const char* name, double scalarTime, double simdTime)
+			{
+				std::cout << "\t" << std::left << std::setw(24) << name << std::right << std::fixed << std::setprecision(2)
+					<< std::setw(8) << scalarTime << " ns" << std::setw(8) << simdTime << " ns" << std::setw(8) << scalarTime / simdTime << "x\n";
+			}
+
+			//operations without a reference version, time and rate only
+			void PrintThroughput(const char* name, double time)
+			{
+				std::cout << "\t" << std::left << std::setw(24) << name << std::right << std::fixed << std::setprecision(2)
+					<< std::setw(8) << time << " ns" << std::setw(8) << 1e3 / time << " M/s\n";
+			}
+
+			//software texture with a gradient, every channel changes within a block so the decode is not trivial
+			Texture* CreateBenchmarkTexture(int size)
+			{
+				SDL_Surface* pSurface{ SDL_CreateRGBSurfaceWithFormat(0, size, size, 32, SDL_PIXELFORMAT_ABGR8888) };
+				uint32_t* pPixels{ static_cast<uint32_t*>(pSurface->pixels) };
+
+				for (int y{ 0 }; y < size; ++y)
+				{
+					for (int x{ 0 }; x < size; ++x)
+					{
+						pPixels[x + y * pSurface->pitch / 4] = static_cast<uint32_t>(x & 0xFF) | static_cast<uint32_t>(y & 0xFF) << 8 | static_cast<uint32_t>((x ^ y) & 0xFF) << 16 | 0xFF000000u;
+					}
+				}
+
+				return Texture::LoadFromSurface(pSurface, nullptr);
+			}
+		}
+
+		void Run()
+		{
+			//deterministic input data
+			std::vector<Vector3> points(nrOfElements);
+			std::vector<Vector4> points4(nrOfElements);
+			std::vector<Matrix> matrices(nrOfElements);
+
+			for (int idx{ 0 }; idx < nrOfElements; ++idx)
+			{
+				const float value{ static_cast<float>(idx) * 0.01f };
+
+				points[idx] = Vector3{ value, -value * 0.5f, value * 2.f };
+				points4[idx] = Vector4{ points[idx], 1.f };
+				matrices[idx] = Matrix::CreateRotationY(value) * Matrix::CreateTranslation(value, 1.f, -value);
+			}
+
+			const Matrix matrix{ Matrix::CreateRotation(0.3f, 0.7f, 0.1f) * Matrix::CreateTranslation(1.f, 2.f, 3.f) * Matrix::CreatePerspectiveFovLH(0.8f, 1.33f, 0.1f, 100.f) };
+			const ScalarMatrix scalarMatrix{ ToScalar(matrix) };
+
+			std::vector<ScalarMatrix> scalarMatrices(nrOfElements);
+			std::transform(matrices.begin(), matrices.end(), scalarMatrices.begin(), ToScalar);
+
+			std::cout << "\033[36m"; // TEXT COLOR
+			std::cout << "[Math Benchmark] " << nrOfElements << " elements x " << nrOfIterations << " iterations, time per operation\n\n";
+			std::cout << "\t" << std::left << std::setw(24) << "operation" << std::right << std::setw(11) << "out of line" << std::setw(11) << "sse" << std::setw(9) << "gain" << "\n";
+
+			//results go to memory like in the vertex loop, a running sum would only measure the add latency
+			std::vector<Vector3> results(nrOfElements);
+			std::vector<Vector4> results4(nrOfElements);
+			std::vector<Matrix> resultMatrices(nrOfElements);
+			std::vector<ScalarMatrix> scalarResultMatrices(nrOfElements);
+
+			PrintResult("TransformPoint",
+				MeasureNanoseconds([&] { for (int idx{ 0 }; idx < nrOfElements; ++idx) results[idx] = ScalarTransformPoint(scalarMatrix, points[idx]); }),
+				MeasureNanoseconds([&] { for (int idx{ 0 }; idx < nrOfElements; ++idx) results[idx] = matrix.TransformPoint(points[idx]); }));
+
+			PrintResult("TransformVector",
+				MeasureNanoseconds([&] { for (int idx{ 0 }; idx < nrOfElements; ++idx) results[idx] = ScalarTransformVector(scalarMatrix, points[idx]); }),
+				MeasureNanoseconds([&] { for (int idx{ 0 }; idx < nrOfElements; ++idx) results[idx] = matrix.TransformVector(points[idx]); }));
+
+			PrintResult("TransformPoint (Vector4)",
+				MeasureNanoseconds([&] { for (int idx{ 0 }; idx < nrOfElements; ++idx) results4[idx] = ScalarTransformPoint4(scalarMatrix, points4[idx]); }),
+				MeasureNanoseconds([&] { for (int idx{ 0 }; idx < nrOfElements; ++idx) results4[idx] = matrix.TransformPoint(points4[idx]); }));
+
+			PrintResult("Matrix * Matrix",
+				MeasureNanoseconds([&] { for (int idx{ 0 }; idx < nrOfElements; ++idx) scalarResultMatrices[idx] = ScalarMultiply(scalarMatrices[idx], scalarMatrix); }),
+				MeasureNanoseconds([&] { for (int idx{ 0 }; idx < nrOfElements; ++idx) resultMatrices[idx] = matrices[idx] * matrix; }));
+
+			PrintResult("Vector4 + Vector4",
+				MeasureNanoseconds([&] { for (int idx{ 0 }; idx < nrOfElements; ++idx) results4[idx] = ScalarAdd(points4[idx], results4[idx]); }),
+				MeasureNanoseconds([&] { for (int idx{ 0 }; idx < nrOfElements; ++idx) results4[idx] = points4[idx] + results4[idx]; }));
+
+			//batch version against the out of line per element version, 1 thread and all threads
+			std::vector<float> soa(nrOfElements * 3);
+			const Vector3Streams streams{ { soa.data(), nrOfElements }, { soa.data() + nrOfElements, nrOfElements }, { soa.data() + nrOfElements * 2, nrOfElements } };
+			const std::span<const float> pointStream{ &points[0].x, points.size() * 3 };
+
+			const double perElementTime{ MeasureNanoseconds([&] { for (int idx{ 0 }; idx < nrOfElements; ++idx) results[idx] = ScalarTransformPoint(scalarMatrix, points[idx]); }) };
+
+			PrintResult("TransformPoints (batch)", perElementTime, MeasureNanoseconds([&] { matrix.TransformPoints(pointStream, 3, streams); }));
+			PrintResult("TransformPoints (MT)", perElementTime, MeasureNanoseconds([&] { matrix.TransformPoints(pointStream, 3, streams, std::thread::hardware_concurrency()); }));
+
+			//pixel output, MaxToOne and SDL_MapRGB per pixel against the format resolved once and 8 pixels packed at a time
+			SDL_PixelFormat* pFormat{ SDL_AllocFormat(SDL_PIXELFORMAT_RGB888) };
+			const PixelPacker packer{ pFormat };
+
+			std::vector<ColorRGB> colors(nrOfElements);
+			std::vector<uint32_t> pixels(nrOfElements);
+
+			//some channels above 1 so the scale down is taken as well
+			for (int idx{ 0 }; idx < nrOfElements; ++idx)
+			{
+				const float value{ static_cast<float>(idx) * 0.01f };
+
+				colors[idx] = ColorRGB{ std::fmod(value, 1.5f), std::fmod(value * 0.7f, 1.f), std::fmod(value * 1.3f, 1.2f) };
+			}
+
+			PrintResult("Pixel output",
+				MeasureNanoseconds([&]
+				{
+					for (int idx{ 0 }; idx < nrOfElements; ++idx)
+					{
+						ColorRGB color{ colors[idx] };
+						color.MaxToOne();
+
+						pixels[idx] = SDL_MapRGB(pFormat, static_cast<uint8_t>(color.r * 255), static_cast<uint8_t>(color.g * 255), static_cast<uint8_t>(color.b * 255));
+					}
+				}),
+				MeasureNanoseconds([&]
+				{
+					PixelBatch batch{ packer, pixels.data() };
+
+					for (int idx{ 0 }; idx < nrOfElements; ++idx)
+					{
+						batch.Add(idx, colors[idx]);
+					}
+				}));
+
+			SDL_FreeFormat(pFormat);
+
+			//sampler, uvs walk along scanlines like the rasterizer does, the block cache sees the same hit rate
+			std::vector<Vector2> uvs(nrOfElements);
+
+			for (int idx{ 0 }; idx < nrOfElements; ++idx)
+			{
+				uvs[idx] = Vector2{ static_cast<float>(idx % 64) / 64.f, static_cast<float>(idx / 64) / 64.f };
+			}
+
+			constexpr int textureSize{ 256 };
+
+			Texture* pUncompressed{ CreateBenchmarkTexture(textureSize) };
+			Texture* pCompressed{ CreateBenchmarkTexture(textureSize) };
+			pCompressed->Compress(TextureFormat::BC1);
+
+			std::vector<ColorRGB> samples(nrOfElements);
+
+			PrintThroughput("Sample (RGBA8)", MeasureNanoseconds([&] { for (int idx{ 0 }; idx < nrOfElements; ++idx) samples[idx] = pUncompressed->Sample(uvs[idx]); }));
+			PrintThroughput("Sample (BC1)", MeasureNanoseconds([&] { for (int idx{ 0 }; idx < nrOfElements; ++idx) samples[idx] = pCompressed->Sample(uvs[idx]); }));
+
+			delete pUncompressed;
+			delete pCompressed;
+
+			const float sum{ samples[nrOfElements - 1].r +  static_cast<float>(pixels[nrOfElements - 1]) + results[nrOfElements - 1].x + results4[nrOfElements - 1].w + resultMatrices[nrOfElements - 1][3][3] + scalarResultMatrices[nrOfElements - 1].m[3][3] + soa[nrOfElements * 3 - 1] };
+
+			g_Sink = sum;
+
+			std::cout << "\n";
+		}
+	}
+}
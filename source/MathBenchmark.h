@@ -0,0 +1,11 @@
+#pragma once
+
+namespace dae
+{
+	//times the hot math operations against plain scalar reference versions and prints the speedup
+	//start the application with -benchmark to run it
+	namespace MathBenchmark
+	{
+		void Run();
+	}
+}
@@ -1,4 +1,5 @@
 #pragma once
+#include <algorithm>
 #include <cmath>
 
 namespace dae
@@ -21,12 +22,12 @@ namespace dae
 	constexpr auto TO_RADIANS(PI / 180.0f);
 
 	/* --- HELPER FUNCTIONS --- */
-	inline float Square(float a)
+	constexpr float Square(float a)
 	{
 		return a * a;
 	}
 
-	inline float Lerpf(float a, float b, float factor)
+	constexpr float Lerpf(float a, float b, float factor)
 	{
 		return ((1 - factor) * a) + (factor * b);
 	}
@@ -36,28 +37,28 @@ namespace dae
 		return abs(a - b) < epsilon;
 	}
 
-	inline int Clamp(const int v, int min, int max)
+	constexpr int Clamp(const int v, int min, int max)
 	{
 		if (v < min) return min;
 		if (v > max) return max;
 		return v;
 	}
 
-	inline float Clamp(const float v, float min, float max)
+	constexpr float Clamp(const float v, float min, float max)
 	{
 		if (v < min) return min;
 		if (v > max) return max;
 		return v;
 	}
 
-	inline float Saturate(const float v)
+	constexpr float Saturate(const float v)
 	{
 		if (v < 0.f) return 0.f;
 		if (v > 1.f) return 1.f;
 		return v;
 	}
 
-	inline float Remap(float depthValue, const float min, const float max)
+	constexpr float Remap(float depthValue, const float min, const float max)
 	{
 		depthValue = std::clamp(depthValue, min, max);
 
@@ -6,89 +6,200 @@
 
 #include "MathHelpers.h"
 #include <cmath>
+#include <emmintrin.h>
+#include "JobSystem.h"
 
 namespace dae {
-	Matrix::Matrix(const Vector3& xAxis, const Vector3& yAxis, const Vector3& zAxis, const Vector3& t) :
-		Matrix({ xAxis, 0 }, { yAxis, 0 }, { zAxis, 0 }, { t, 1 })
+	namespace
 	{
-	}
+		//smaller batches are not worth the scheduling
+		constexpr size_t minElementsPerThread{ 16384 };
 
-	Matrix::Matrix(const Vector4& xAxis, const Vector4& yAxis, const Vector4& zAxis, const Vector4& t)
-	{
-		data[0] = xAxis;
-		data[1] = yAxis;
-		data[2] = zAxis;
-		data[3] = t;
-	}
+		//calls function(begin, end) on chunks of the range, chunks are multiples of 4 so only the last one has a scalar tail
+		template<typename Function>
+		void ForEachChunk(size_t count, unsigned int nrOfThreads, Function function)
+		{
+			const size_t nrOfChunks{ std::clamp<size_t>(count / minElementsPerThread, 1, std::max(nrOfThreads, 1u)) };
 
-	Matrix::Matrix(const Matrix& m)
-	{
-		data[0] = m[0];
-		data[1] = m[1];
-		data[2] = m[2];
-		data[3] = m[3];
-	}
+			if (nrOfChunks == 1)
+			{
+				function(size_t{ 0 }, count);
+				return;
+			}
 
-	Vector3 Matrix::TransformVector(const Vector3& v) const
-	{
-		return TransformVector(v.x, v.y, v.z);
-	}
+			const size_t chunkSize{ ((count + nrOfChunks - 1) / nrOfChunks + 3) & ~size_t{ 3 } };
 
-	Vector3 Matrix::TransformVector(float x, float y, float z) const
-	{
-		return Vector3{
-			data[0].x * x + data[1].x * y + data[2].x * z,
-			data[0].y * x + data[1].y * y + data[2].y * z,
-			data[0].z * x + data[1].z * y + data[2].z * z
+			//the calling thread takes the first chunk
+			JobSystem::ParallelFor(count, chunkSize, function, "transform chunk");
+		}
+
+		//loads component offset of 4 consecutive elements of a strided stream into one register
+		__m128 LoadStream(const float* pInput, size_t stride, size_t offset)
+		{
+			return _mm_setr_ps(pInput[offset], pInput[offset + stride], pInput[offset + stride * 2], pInput[offset + stride * 3]);
+		}
+
+		//unorm elements are converted to [0, 1]
+		__m128 LoadStream(const uint16_t* pInput, size_t stride, size_t offset)
+		{
+			const __m128i integers{ _mm_setr_epi32(pInput[offset], pInput[offset + stride], pInput[offset + stride * 2], pInput[offset + stride * 3]) };
+
+			return _mm_mul_ps(_mm_cvtepi32_ps(integers), _mm_set1_ps(1.f / 65535.f));
+		}
+
+		constexpr float ToFloat(float value) { return value; }
+		constexpr float ToFloat(uint16_t value) { return static_cast<float>(value) * (1.f / 65535.f); }
+
+		//every element of the matrix broadcast into its own register, made once per batch
+		//the output stores could alias the matrix, so the compiler would reload it every iteration otherwise
+		struct BroadcastMatrix
+		{
+			__m128 elements[4][4];
+
+			explicit BroadcastMatrix(const Matrix& m)
+			{
+				for (int row{ 0 }; row < 4; ++row)
+				{
+					for (int column{ 0 }; column < 4; ++column)
+					{
+						elements[row][column] = _mm_set1_ps(m[row][column]);
+					}
+				}
+			}
+
+			//x * m[0][column] + y * m[1][column] + z * m[2][column] (+ m[3][column]) for 4 elements at once
+			template<bool isPoint>
+			__m128 TransformColumn(int column, __m128 x, __m128 y, __m128 z) const
+			{
+				__m128 result{ _mm_mul_ps(x, elements[0][column]) };
+				result = _mm_add_ps(result, _mm_mul_ps(y, elements[1][column]));
+				result = _mm_add_ps(result, _mm_mul_ps(z, elements[2][column]));
+
+				if constexpr (isPoint) result = _mm_add_ps(result, elements[3][column]);
+
+				return result;
+			}
 		};
+
+		template<bool isPoint, typename Element>
+		void TransformStream(const Matrix& m, std::span<const Element> input, size_t stride, const Vector3Streams& output, unsigned int nrOfThreads)
+		{
+			const size_t count{ output.x.size() };
+
+			assert(output.y.size() == count && output.z.size() == count);
+			assert(count == 0 || input.size() >= (count - 1) * stride + 3);
+
+			ForEachChunk(count, nrOfThreads, [&](size_t begin, size_t end)
+			{
+				const BroadcastMatrix broadcast{ m };
+				const Element* pInput{ input.data() };
+
+				size_t idx{ begin };
+
+				//4 elements per iteration
+				for (; idx + 4 <= end; idx += 4)
+				{
+					const Element* pElement{ pInput + idx * stride };
+
+					const __m128 x{ LoadStream(pElement, stride, 0) };
+					const __m128 y{ LoadStream(pElement, stride, 1) };
+					const __m128 z{ LoadStream(pElement, stride, 2) };
+
+					_mm_storeu_ps(&output.x[idx], broadcast.TransformColumn<isPoint>(0, x, y, z));
+					_mm_storeu_ps(&output.y[idx], broadcast.TransformColumn<isPoint>(1, x, y, z));
+					_mm_storeu_ps(&output.z[idx], broadcast.TransformColumn<isPoint>(2, x, y, z));
+				}
+
+				//scalar tail
+				for (; idx < end; ++idx)
+				{
+					const Element* pElement{ pInput + idx * stride };
+
+					const float x{ ToFloat(pElement[0]) };
+					const float y{ ToFloat(pElement[1]) };
+					const float z{ ToFloat(pElement[2]) };
+
+					const Vector3 result{ isPoint ? m.TransformPoint(x, y, z) : m.TransformVector(x, y, z) };
+
+					output.x[idx] = result.x;
+					output.y[idx] = result.y;
+					output.z[idx] = result.z;
+				}
+			});
+		}
+
+		template<typename Element>
+		void ProjectStream(const Matrix& m, std::span<const Element> input, size_t stride, const Vector4Streams& output, unsigned int nrOfThreads)
+		{
+			const size_t count{ output.x.size() };
+
+			assert(output.y.size() == count && output.z.size() == count && output.w.size() == count);
+			assert(count == 0 || input.size() >= (count - 1) * stride + 3);
+
+			ForEachChunk(count, nrOfThreads, [&](size_t begin, size_t end)
+			{
+				const BroadcastMatrix broadcast{ m };
+				const Element* pInput{ input.data() };
+
+				size_t idx{ begin };
+
+				//4 elements per iteration
+				for (; idx + 4 <= end; idx += 4)
+				{
+					const Element* pElement{ pInput + idx * stride };
+
+					const __m128 x{ LoadStream(pElement, stride, 0) };
+					const __m128 y{ LoadStream(pElement, stride, 1) };
+					const __m128 z{ LoadStream(pElement, stride, 2) };
+
+					const __m128 w{ broadcast.TransformColumn<true>(3, x, y, z) };
+
+					//perspective divide
+					_mm_storeu_ps(&output.x[idx], _mm_div_ps(broadcast.TransformColumn<true>(0, x, y, z), w));
+					_mm_storeu_ps(&output.y[idx], _mm_div_ps(broadcast.TransformColumn<true>(1, x, y, z), w));
+					_mm_storeu_ps(&output.z[idx], _mm_div_ps(broadcast.TransformColumn<true>(2, x, y, z), w));
+					_mm_storeu_ps(&output.w[idx], w);
+				}
+
+				//scalar tail
+				for (; idx < end; ++idx)
+				{
+					const Element* pElement{ pInput + idx * stride };
+
+					const Vector4 result{ m.TransformPoint(ToFloat(pElement[0]), ToFloat(pElement[1]), ToFloat(pElement[2]), 1.f) };
+
+					output.x[idx] = result.x / result.w;
+					output.y[idx] = result.y / result.w;
+					output.z[idx] = result.z / result.w;
+					output.w[idx] = result.w;
+				}
+			});
+		}
 	}
 
-	Vector3 Matrix::TransformPoint(const Vector3& p) const
+	void Matrix::TransformPoints(std::span<const float> input, size_t stride, const Vector3Streams& output, unsigned int nrOfThreads) const
 	{
-		return TransformPoint(p.x, p.y, p.z);
+		TransformStream<true>(*this, input, stride, output, nrOfThreads);
 	}
 
-	Vector3 Matrix::TransformPoint(float x, float y, float z) const
+	void Matrix::TransformVectors(std::span<const float> input, size_t stride, const Vector3Streams& output, unsigned int nrOfThreads) const
 	{
-		return Vector3{
-			data[0].x * x + data[1].x * y + data[2].x * z + data[3].x,
-			data[0].y * x + data[1].y * y + data[2].y * z + data[3].y,
-			data[0].z * x + data[1].z * y + data[2].z * z + data[3].z,
-		};
+		TransformStream<false>(*this, input, stride, output, nrOfThreads);
 	}
 
-	Vector4 Matrix::TransformPoint(const Vector4& p) const
+	void Matrix::TransformAndProject(std::span<const float> input, size_t stride, const Vector4Streams& output, unsigned int nrOfThreads) const
 	{
-		return TransformPoint(p.x, p.y, p.z, p.w);
+		ProjectStream(*this, input, stride, output, nrOfThreads);
 	}
 
-	Vector4 Matrix::TransformPoint(float x, float y, float z, float w) const
+	void Matrix::TransformPoints(std::span<const uint16_t> input, size_t stride, const Vector3Streams& output, unsigned int nrOfThreads) const
 	{
-		return Vector4{
-			data[0].x * x + data[1].x * y + data[2].x * z + data[3].x,
-			data[0].y * x + data[1].y * y + data[2].y * z + data[3].y,
-			data[0].z * x + data[1].z * y + data[2].z * z + data[3].z,
-			data[0].w * x + data[1].w * y + data[2].w * z + data[3].w
-		};
+		TransformStream<true>(*this, input, stride, output, nrOfThreads);
 	}
 
-	const Matrix& Matrix::Transpose()
+	void Matrix::TransformAndProject(std::span<const uint16_t> input, size_t stride, const Vector4Streams& output, unsigned int nrOfThreads) const
 	{
-		Matrix result{};
-		for (int r{ 0 }; r < 4; ++r)
-		{
-			for (int c{ 0 }; c < 4; ++c)
-			{
-				result[r][c] = data[c][r];
-			}
-		}
-
-		data[0] = result[0];
-		data[1] = result[1];
-		data[2] = result[2];
-		data[3] = result[3];
-
-		return *this;
+		ProjectStream(*this, input, stride, output, nrOfThreads);
 	}
 
 	const Matrix& Matrix::Inverse()
@@ -128,14 +239,6 @@ namespace dae {
 		return *this;
 	}
 
-	Matrix Matrix::Transpose(const Matrix& m)
-	{
-		Matrix out{ m };
-		out.Transpose();
-
-		return out;
-	}
-
 	Matrix Matrix::Inverse(const Matrix& m)
 	{
 		Matrix out{ m };
@@ -150,49 +253,6 @@ namespace dae {
 		return {};
 	}
 
-	Matrix Matrix::CreatePerspectiveFovLH(float fov, float aspect, float zn, float zf)
-	{
-		const float frustum{ (zf - zn) };
-
-		return
-		{
-			{1 / (aspect * fov), 0, 0,0},
-			{0, 1 / fov, 0, 0},
-			{0, 0, zf / frustum, 1},
-			{0, 0 , -(zf * zn) / frustum, 0}
-		};
-	}
-
-	Vector3 Matrix::GetAxisX() const
-	{
-		return data[0];
-	}
-
-	Vector3 Matrix::GetAxisY() const
-	{
-		return data[1];
-	}
-
-	Vector3 Matrix::GetAxisZ() const
-	{
-		return data[2];
-	}
-
-	Vector3 Matrix::GetTranslation() const
-	{
-		return data[3];
-	}
-
-	Matrix Matrix::CreateTranslation(float x, float y, float z)
-	{
-		return CreateTranslation({ x, y, z });
-	}
-
-	Matrix Matrix::CreateTranslation(const Vector3& t)
-	{
-		return { Vector3::UnitX, Vector3::UnitY, Vector3::UnitZ, t };
-	}
-
 	Matrix Matrix::CreateRotationX(float pitch)
 	{
 		return {
@@ -232,60 +292,4 @@ namespace dae {
 	{
 		return CreateRotationX(r[0]) * CreateRotationY(r[1]) * CreateRotationZ(r[2]);
 	}
-
-	Matrix Matrix::CreateScale(float sx, float sy, float sz)
-	{
-		return { {sx, 0, 0}, {0, sy, 0}, {0, 0, sz}, Vector3::Zero };
-	}
-
-	Matrix Matrix::CreateScale(const Vector3& s)
-	{
-		return CreateScale(s[0], s[1], s[2]);
-	}
-
-#pragma region Operator Overloads
-	Vector4& Matrix::operator[](int index)
-	{
-		assert(index <= 3 && index >= 0);
-		return data[index];
-	}
-
-	Vector4 Matrix::operator[](int index) const
-	{
-		assert(index <= 3 && index >= 0);
-		return data[index];
-	}
-
-	Matrix Matrix::operator*(const Matrix& m) const
-	{
-		Matrix result{};
-		Matrix m_transposed = Transpose(m);
-
-		for (int r{ 0 }; r < 4; ++r)
-		{
-			for (int c{ 0 }; c < 4; ++c)
-			{
-				result[r][c] = Vector4::Dot(data[r], m_transposed[c]);
-			}
-		}
-
-		return result;
-	}
-
-	const Matrix& Matrix::operator*=(const Matrix& m)
-	{
-		Matrix copy{ *this };
-		Matrix m_transposed = Transpose(m);
-
-		for (int r{ 0 }; r < 4; ++r)
-		{
-			for (int c{ 0 }; c < 4; ++c)
-			{
-				data[r][c] = Vector4::Dot(copy[r], m_transposed[c]);
-			}
-		}
-
-		return *this;
-	}
-#pragma endregion
 }
\ No newline at end of file
@@ -1,64 +1,105 @@
 #pragma once
+#include <cassert>
+#include <span>
+#include <type_traits>
+#include <xmmintrin.h>
 #include "Vector3.h"
 #include "Vector4.h"
 
 namespace dae {
+	//structure of arrays output of the batch transforms, one span per component
+	struct Vector3Streams
+	{
+		std::span<float> x;
+		std::span<float> y;
+		std::span<float> z;
+	};
+
+	struct Vector4Streams
+	{
+		std::span<float> x;
+		std::span<float> y;
+		std::span<float> z;
+		std::span<float> w;
+	};
+
 	struct Matrix
 	{
-		Matrix() = default;
-		Matrix(
+		constexpr Matrix() = default;
+		constexpr Matrix(
 			const Vector3& xAxis,
 			const Vector3& yAxis,
 			const Vector3& zAxis,
 			const Vector3& t);
 
-		Matrix(
+		constexpr Matrix(
 			const Vector4& xAxis,
 			const Vector4& yAxis,
 			const Vector4& zAxis,
 			const Vector4& t);
 
-		Matrix(const Matrix& m);
+		constexpr Matrix(const Matrix& m);
+		constexpr Matrix& operator=(const Matrix& m) = default;
 
-		Vector3 TransformVector(const Vector3& v) const;
-		Vector3 TransformVector(float x, float y, float z) const;
-		Vector3 TransformPoint(const Vector3& p) const;
-		Vector3 TransformPoint(float x, float y, float z) const;
+		constexpr Vector3 TransformVector(const Vector3& v) const;
+		constexpr Vector3 TransformVector(float x, float y, float z) const;
+		constexpr Vector3 TransformPoint(const Vector3& p) const;
+		constexpr Vector3 TransformPoint(float x, float y, float z) const;
 
-		Vector4 TransformPoint(const Vector4& p) const;
-		Vector4 TransformPoint(float x, float y, float z, float w) const;
+		constexpr Vector4 TransformPoint(const Vector4& p) const;
+		constexpr Vector4 TransformPoint(float x, float y, float z, float w) const;
 
-		const Matrix& Transpose();
+		//batch versions, the input is a float stream with stride floats between consecutive elements
+		//(sizeof(Vertex) / sizeof(float) reads the positions straight out of a vertex array)
+		//the number of elements is the size of the output streams
+		//nrOfThreads splits large batches into chunks that are transformed in parallel
+		void TransformPoints(std::span<const float> input, size_t stride, const Vector3Streams& output, unsigned int nrOfThreads = 1) const;
+		void TransformVectors(std::span<const float> input, size_t stride, const Vector3Streams& output, unsigned int nrOfThreads = 1) const;
+
+		//transforms the points with w = 1 and divides x, y and z by w, w itself is kept for perspective correct interpolation
+		void TransformAndProject(std::span<const float> input, size_t stride, const Vector4Streams& output, unsigned int nrOfThreads = 1) const;
+
+		//same for 16 bit unorm input (quantized positions), stride is in uint16_t and the elements are read as [0, 1]
+		//the dequantization is expected to be part of the matrix
+		void TransformPoints(std::span<const uint16_t> input, size_t stride, const Vector3Streams& output, unsigned int nrOfThreads = 1) const;
+		void TransformAndProject(std::span<const uint16_t> input, size_t stride, const Vector4Streams& output, unsigned int nrOfThreads = 1) const;
+
+		constexpr const Matrix& Transpose();
 		const Matrix& Inverse();
 
-		Vector3 GetAxisX() const;
-		Vector3 GetAxisY() const;
-		Vector3 GetAxisZ() const;
-		Vector3 GetTranslation() const;
+		//inverse of a rigid transform (orthonormal axes + translation), a transpose and a rotated translation
+		//only valid without scale or shear, use Inverse for those
+		constexpr const Matrix& InverseRigid();
 
-		static Matrix CreateTranslation(float x, float y, float z);
-		static Matrix CreateTranslation(const Vector3& t);
+		constexpr Vector3 GetAxisX() const { return data[0]; }
+		constexpr Vector3 GetAxisY() const { return data[1]; }
+		constexpr Vector3 GetAxisZ() const { return data[2]; }
+		constexpr Vector3 GetTranslation() const { return data[3]; }
+
+		static constexpr Matrix CreateTranslation(float x, float y, float z);
+		static constexpr Matrix CreateTranslation(const Vector3& t);
 		static Matrix CreateRotationX(float pitch);
 		static Matrix CreateRotationY(float yaw);
 		static Matrix CreateRotationZ(float roll);
 		static Matrix CreateRotation(float pitch, float yaw, float roll);
 		static Matrix CreateRotation(const Vector3& r);
-		static Matrix CreateScale(float sx, float sy, float sz);
-		static Matrix CreateScale(const Vector3& s);
-		static Matrix Transpose(const Matrix& m);
+		static constexpr Matrix CreateScale(float sx, float sy, float sz);
+		static constexpr Matrix CreateScale(const Vector3& s);
+		static constexpr Matrix Transpose(const Matrix& m);
 		static Matrix Inverse(const Matrix& m);
+		static constexpr Matrix InverseRigid(const Matrix& m);
 
 		static Matrix CreateLookAtLH(const Vector3& origin, const Vector3& forward, const Vector3& up);
-		static Matrix CreatePerspectiveFovLH(float fovy, float aspect, float zn, float zf);
+		static constexpr Matrix CreatePerspectiveFovLH(float fovy, float aspect, float zn, float zf);
 
-		Vector4& operator[](int index);
-		Vector4 operator[](int index) const;
-		Matrix operator*(const Matrix& m) const;
-		const Matrix& operator*=(const Matrix& m);
+		constexpr Vector4& operator[](int index);
+		constexpr Vector4 operator[](int index) const;
+		constexpr Matrix operator*(const Matrix& m) const;
+		constexpr const Matrix& operator*=(const Matrix& m);
 
 	private:
 
-		//Row-Major Matrix
+		//Row-Major Matrix, every row is 16 byte aligned
 		Vector4 data[4]
 		{
 			{1,0,0,0}, //xAxis
@@ -71,5 +112,238 @@ namespace dae {
 		// v1x v1y v1z v1w
 		// v2x v2y v2z v2w
 		// v3x v3y v3z v3w
+
+		//x * row0 + y * row1 + z * row2 + w * row3, same order as the scalar version
+		__m128 Transform(__m128 x, __m128 y, __m128 z) const;
+		__m128 Transform(__m128 x, __m128 y, __m128 z, __m128 w) const;
+
+		//compile time version of the transforms, the sse path cannot be constant evaluated
+		constexpr Vector4 TransformScalar(float x, float y, float z, float w) const;
 	};
+
+	static_assert(sizeof(Matrix) == 16 * sizeof(float), "the effects upload the matrix as 16 floats");
+
+	//hot operations are inline so they can be folded into the vertex and pixel loops
+	//everything that does not need sse or trigonometry is constexpr, constant expressions use the scalar path
+
+	constexpr Matrix::Matrix(const Vector3& xAxis, const Vector3& yAxis, const Vector3& zAxis, const Vector3& t) :
+		Matrix({ xAxis, 0 }, { yAxis, 0 }, { zAxis, 0 }, { t, 1 })
+	{
+	}
+
+	constexpr Matrix::Matrix(const Vector4& xAxis, const Vector4& yAxis, const Vector4& zAxis, const Vector4& t) :
+		data{ xAxis, yAxis, zAxis, t }
+	{
+	}
+
+	constexpr Matrix::Matrix(const Matrix& m) :
+		data{ m.data[0], m.data[1], m.data[2], m.data[3] }
+	{
+	}
+
+	inline __m128 Matrix::Transform(__m128 x, __m128 y, __m128 z) const
+	{
+		__m128 result{ _mm_mul_ps(x, data[0].Load()) };
+		result = _mm_add_ps(result, _mm_mul_ps(y, data[1].Load()));
+		return _mm_add_ps(result, _mm_mul_ps(z, data[2].Load()));
+	}
+
+	inline __m128 Matrix::Transform(__m128 x, __m128 y, __m128 z, __m128 w) const
+	{
+		return _mm_add_ps(Transform(x, y, z), _mm_mul_ps(w, data[3].Load()));
+	}
+
+	constexpr Vector4 Matrix::TransformScalar(float x, float y, float z, float w) const
+	{
+		return Vector4{
+			data[0].x * x + data[1].x * y + data[2].x * z + data[3].x * w,
+			data[0].y * x + data[1].y * y + data[2].y * z + data[3].y * w,
+			data[0].z * x + data[1].z * y + data[2].z * z + data[3].z * w,
+			data[0].w * x + data[1].w * y + data[2].w * z + data[3].w * w
+		};
+	}
+
+	constexpr Vector3 Matrix::TransformVector(const Vector3& v) const
+	{
+		return TransformVector(v.x, v.y, v.z);
+	}
+
+	constexpr Vector3 Matrix::TransformVector(float x, float y, float z) const
+	{
+		if (std::is_constant_evaluated()) return TransformScalar(x, y, z, 0.f);
+
+		const Vector4 result{ Vector4::FromSSE(Transform(_mm_set1_ps(x), _mm_set1_ps(y), _mm_set1_ps(z))) };
+		return { result.x, result.y, result.z };
+	}
+
+	constexpr Vector3 Matrix::TransformPoint(const Vector3& p) const
+	{
+		return TransformPoint(p.x, p.y, p.z);
+	}
+
+	constexpr Vector3 Matrix::TransformPoint(float x, float y, float z) const
+	{
+		if (std::is_constant_evaluated()) return TransformScalar(x, y, z, 1.f);
+
+		const Vector4 result{ Vector4::FromSSE(_mm_add_ps(Transform(_mm_set1_ps(x), _mm_set1_ps(y), _mm_set1_ps(z)), data[3].Load())) };
+		return { result.x, result.y, result.z };
+	}
+
+	constexpr Vector4 Matrix::TransformPoint(const Vector4& p) const
+	{
+		return TransformPoint(p.x, p.y, p.z, p.w);
+	}
+
+	constexpr Vector4 Matrix::TransformPoint(float x, float y, float z, [[maybe_unused]] float w) const
+	{
+		//w of the input is ignored like the scalar version, the translation row is always added
+		if (std::is_constant_evaluated()) return TransformScalar(x, y, z, 1.f);
+
+		return Vector4::FromSSE(_mm_add_ps(Transform(_mm_set1_ps(x), _mm_set1_ps(y), _mm_set1_ps(z)), data[3].Load()));
+	}
+
+	constexpr const Matrix& Matrix::Transpose()
+	{
+		if (std::is_constant_evaluated())
+		{
+			const Matrix copy{ *this };
+
+			for (int r{ 0 }; r < 4; ++r)
+			{
+				for (int c{ 0 }; c < 4; ++c)
+				{
+					data[r][c] = copy.data[c][r];
+				}
+			}
+
+			return *this;
+		}
+
+		__m128 row0{ data[0].Load() };
+		__m128 row1{ data[1].Load() };
+		__m128 row2{ data[2].Load() };
+		__m128 row3{ data[3].Load() };
+
+		_MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+
+		data[0].Store(row0);
+		data[1].Store(row1);
+		data[2].Store(row2);
+		data[3].Store(row3);
+
+		return *this;
+	}
+
+	constexpr Matrix Matrix::Transpose(const Matrix& m)
+	{
+		Matrix out{ m };
+		out.Transpose();
+
+		return out;
+	}
+
+	constexpr const Matrix& Matrix::InverseRigid()
+	{
+		const Vector3 xAxis{ data[0] };
+		const Vector3 yAxis{ data[1] };
+		const Vector3 zAxis{ data[2] };
+		const Vector3 translation{ data[3] };
+
+		//transpose the rotation part only
+		data[3] = Vector4{ 0, 0, 0, 1 };
+		Transpose();
+
+		//move the translation back through the inverse rotation
+		data[3] = Vector4{ -Vector3::Dot(translation, xAxis), -Vector3::Dot(translation, yAxis), -Vector3::Dot(translation, zAxis), 1 };
+
+		return *this;
+	}
+
+	constexpr Matrix Matrix::InverseRigid(const Matrix& m)
+	{
+		Matrix out{ m };
+		out.InverseRigid();
+
+		return out;
+	}
+
+	constexpr Matrix Matrix::CreateTranslation(float x, float y, float z)
+	{
+		return CreateTranslation({ x, y, z });
+	}
+
+	constexpr Matrix Matrix::CreateTranslation(const Vector3& t)
+	{
+		return { Vector3::UnitX, Vector3::UnitY, Vector3::UnitZ, t };
+	}
+
+	constexpr Matrix Matrix::CreateScale(float sx, float sy, float sz)
+	{
+		return { Vector3{ sx, 0, 0 }, Vector3{ 0, sy, 0 }, Vector3{ 0, 0, sz }, Vector3::Zero };
+	}
+
+	constexpr Matrix Matrix::CreateScale(const Vector3& s)
+	{
+		return CreateScale(s[0], s[1], s[2]);
+	}
+
+	constexpr Matrix Matrix::CreatePerspectiveFovLH(float fov, float aspect, float zn, float zf)
+	{
+		const float frustum{ (zf - zn) };
+
+		return
+		{
+			Vector4{ 1 / (aspect * fov), 0, 0, 0 },
+			Vector4{ 0, 1 / fov, 0, 0 },
+			Vector4{ 0, 0, zf / frustum, 1 },
+			Vector4{ 0, 0, -(zf * zn) / frustum, 0 }
+		};
+	}
+
+#pragma region Operator Overloads
+	constexpr Vector4& Matrix::operator[](int index)
+	{
+		assert(index <= 3 && index >= 0);
+		return data[index];
+	}
+
+	constexpr Vector4 Matrix::operator[](int index) const
+	{
+		assert(index <= 3 && index >= 0);
+		return data[index];
+	}
+
+	constexpr Matrix Matrix::operator*(const Matrix& m) const
+	{
+		//every row of the result is the row of this matrix transformed by m
+		Matrix result;
+
+		for (int r{ 0 }; r < 4; ++r)
+		{
+			const Vector4& row{ data[r] };
+
+			if (std::is_constant_evaluated())
+			{
+				result.data[r] = m.TransformScalar(row.x, row.y, row.z, row.w);
+				continue;
+			}
+
+			const __m128 sseRow{ row.Load() };
+
+			result.data[r].Store(m.Transform(
+				_mm_shuffle_ps(sseRow, sseRow, _MM_SHUFFLE(0, 0, 0, 0)),
+				_mm_shuffle_ps(sseRow, sseRow, _MM_SHUFFLE(1, 1, 1, 1)),
+				_mm_shuffle_ps(sseRow, sseRow, _MM_SHUFFLE(2, 2, 2, 2)),
+				_mm_shuffle_ps(sseRow, sseRow, _MM_SHUFFLE(3, 3, 3, 3))));
+		}
+
+		return result;
+	}
+
+	constexpr const Matrix& Matrix::operator*=(const Matrix& m)
+	{
+		*this = *this * m;
+		return *this;
+	}
+#pragma endregion
 }
\ No newline at end of file
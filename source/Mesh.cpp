@@ -6,9 +6,9 @@
 
 namespace dae
 {
-	Mesh::Mesh(ID3D11Device* pDevice, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, const EffectType typeEffect)
-		:m_Vertices{std::move(vertices)},
-		 m_Indices{std::move(indices)}
+	Mesh::Mesh(ID3D11Device* pDevice, MeshData data, const EffectType typeEffect)
+		:m_Data{std::move(data)},
+		 m_DequantizationMatrix{VertexQuantization::GetDequantizationMatrix(m_Data.bounds)}
 	{
 
 		switch (typeEffect)
@@ -26,6 +26,7 @@ namespace dae
 		if(m_pEffect != nullptr)
 		{
 			m_pTechnique = m_pEffect->GetTechnique();
+			m_pEffect->SetPositionBounds(m_Data.bounds.min, m_Data.bounds.extent);
 		}
 
 		//Create Vertex Layout
@@ -33,23 +34,23 @@ namespace dae
 		D3D11_INPUT_ELEMENT_DESC vertexDesc[numElements]{};
 
 		vertexDesc[0].SemanticName = "POSITION";
-		vertexDesc[0].Format = DXGI_FORMAT_R32G32B32_FLOAT;
-		vertexDesc[0].AlignedByteOffset = 0;
+		vertexDesc[0].Format = DXGI_FORMAT_R16G16B16A16_UNORM;
+		vertexDesc[0].AlignedByteOffset = offsetof(PackedVertex, position);
 		vertexDesc[0].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
 
 		vertexDesc[1].SemanticName = "NORMAL";
-		vertexDesc[1].Format = DXGI_FORMAT_R32G32B32_FLOAT;
-		vertexDesc[1].AlignedByteOffset = 12;
+		vertexDesc[1].Format = DXGI_FORMAT_R16G16_SNORM;
+		vertexDesc[1].AlignedByteOffset = offsetof(PackedVertex, normal);
 		vertexDesc[1].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
 
 		vertexDesc[2].SemanticName = "TANGENT";
-		vertexDesc[2].Format = DXGI_FORMAT_R32G32B32_FLOAT;
-		vertexDesc[2].AlignedByteOffset = 24;
+		vertexDesc[2].Format = DXGI_FORMAT_R16G16_SNORM;
+		vertexDesc[2].AlignedByteOffset = offsetof(PackedVertex, tangent);
 		vertexDesc[2].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
 
 		vertexDesc[3].SemanticName = "TEXCOORD";
-		vertexDesc[3].Format = DXGI_FORMAT_R32G32_FLOAT;
-		vertexDesc[3].AlignedByteOffset = 36;
+		vertexDesc[3].Format = DXGI_FORMAT_R16G16_FLOAT;
+		vertexDesc[3].AlignedByteOffset = offsetof(PackedVertex, uv);
 		vertexDesc[3].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
 
 		//Create Input Layout
@@ -71,26 +72,26 @@ namespace dae
 		//Create vertex buffer
 		D3D11_BUFFER_DESC bd{};
 		bd.Usage = D3D11_USAGE_IMMUTABLE;
-		bd.ByteWidth = sizeof(Vertex) * static_cast<uint32_t>(m_Vertices.size());
+		bd.ByteWidth = static_cast<uint32_t>(m_Data.packedVertices.size_bytes());
 		bd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
 		bd.CPUAccessFlags = 0;
 		bd.MiscFlags = 0;
 
 		D3D11_SUBRESOURCE_DATA initData{};
-		initData.pSysMem = m_Vertices.data();
+		initData.pSysMem = m_Data.packedVertices.data();
 
 		result = pDevice->CreateBuffer(&bd, &initData, &m_pVertexBuffer);
 
 		if (FAILED(result)) return;
 
 		//Create index buffer
-		m_NumIndices = static_cast<uint32_t>(m_Indices.size());
+		m_NumIndices = static_cast<uint32_t>(m_Data.indices.size());
 		bd.Usage = D3D11_USAGE_IMMUTABLE;
 		bd.ByteWidth = sizeof(uint32_t) * m_NumIndices;
 		bd.BindFlags = D3D11_BIND_INDEX_BUFFER;
 		bd.CPUAccessFlags = 0;
 		bd.MiscFlags = 0;
-		initData.pSysMem = m_Indices.data();
+		initData.pSysMem = m_Data.indices.data();
 
 		result = pDevice->CreateBuffer(&bd, &initData, &m_pIndexBuffer);
 
@@ -118,7 +119,7 @@ namespace dae
 		pDeviceContext->IASetInputLayout(m_pInputLayout);
 
 		//3. Set Vertex Buffer
-		constexpr UINT stride{ sizeof(Vertex) };
+		constexpr UINT stride{ sizeof(PackedVertex) };
 		constexpr UINT offset{ 0 };
 		pDeviceContext->IASetVertexBuffers(0, 1, &m_pVertexBuffer, &stride, &offset);
 
@@ -131,8 +132,36 @@ namespace dae
 		for (UINT p{ 0 }; p < techDesc.Passes; ++p)
 		{
 			m_pTechnique->GetPassByIndex(p)->Apply(0, pDeviceContext);
-			pDeviceContext->DrawIndexed(m_NumIndices, 0, 0);
+			pDeviceContext->DrawIndexed(GetLod().indexCount, GetLod().indexOffset, 0);
 		}
 	}
 
+	uint32_t Mesh::SelectLod(const Matrix& worldMatrix, uint32_t currentLod, const Vector3& cameraOrigin, float pixelsPerUnit, float maxPixelError, float hysteresis) const
+	{
+		//distance to the bounding sphere of the mesh, the error is in object space and the world matrix does not scale
+		const Vector3 center{ worldMatrix.TransformPoint(m_Data.bounds.min + m_Data.bounds.extent * 0.5f) };
+		const float radius{ m_Data.bounds.extent.Magnitude() * 0.5f };
+
+		const float distance{ std::max((center - cameraOrigin).Magnitude() - radius, 0.1f) };
+
+		const auto coarsestLod = [&](float pixelError)
+		{
+			uint32_t lodIndex{};
+
+			for (uint32_t idx{ 1 }; idx < m_Data.lods.size(); ++idx)
+			{
+				if (m_Data.lods[idx].error / distance * pixelsPerUnit <= pixelError) lodIndex = idx;
+			}
+
+			return lodIndex;
+		};
+
+		//the current lod got too coarse, go finer right away
+		const uint32_t finerLod{ coarsestLod(maxPixelError) };
+
+		if (finerLod < currentLod) return finerLod;
+
+		return std::max(currentLod, coarsestLod(maxPixelError * (1.f - hysteresis)));
+	}
+
 }
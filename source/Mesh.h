@@ -3,6 +3,7 @@
 //#include "ColorRGB.h"
 #include "Effect.h"
 #include "DataTypes.h"
+#include "MeshCache.h"
 
 
 
@@ -14,7 +15,8 @@ namespace dae
 	{
 	public:
 
-		Mesh(ID3D11Device* pDevice, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, const EffectType typeEffect);
+		//the buffers are created straight from the spans of the data, the mesh keeps its storage alive for the software path
+		Mesh(ID3D11Device* pDevice, MeshData data, const EffectType typeEffect);
 		~Mesh();
 
 		Mesh(const Mesh&) = delete;
@@ -24,43 +26,52 @@ namespace dae
 
 		void RenderHardware(ID3D11DeviceContext* pDeviceContext) const;
 
-		void SetProjectionMatrix(const Matrix& matrix) const
+		//rebuilds the world view projection and uploads the matrices to the effect
+		//skipped when neither the world matrix nor the camera changed since the last call
+		void UpdateMatrices(const Matrix& viewProjectionMatrix, const Matrix& invViewMatrix, uint32_t cameraVersion)
 		{
-			m_pEffect->SetProjectionMatrix(m_WorldMatrix * matrix);
-		}
+			const bool isWorldChanged{ m_WorldVersion != m_UploadedWorldVersion };
+			const bool isCameraChanged{ cameraVersion != m_UploadedCameraVersion };
 
-		void SetDiffuse(const Texture* pTexture) const
-		{
-			m_pEffect->SetDiffuseMap(pTexture);
-		}
+			if (!isWorldChanged && !isCameraChanged) return;
 
-		void SetNormal(const Texture* pTexture) const
-		{
-			m_pEffect->SetNormalMap(pTexture);
+			m_WorldViewProjectionMatrix = m_WorldMatrix * viewProjectionMatrix;
+			m_pEffect->SetProjectionMatrix(m_WorldViewProjectionMatrix);
+
+			if (isWorldChanged) m_pEffect->SetWorldMatrix(m_WorldMatrix);
+			if (isCameraChanged) m_pEffect->SetInvViewMatrix(invViewMatrix);
+
+			m_UploadedWorldVersion = m_WorldVersion;
+			m_UploadedCameraVersion = cameraVersion;
 		}
 
-		void SetSpecular(const Texture* pTexture) const 
+		void SetDiffuse(const std::shared_ptr<Texture>& pTexture)
 		{
-			m_pEffect->SetSpecularMap(pTexture);
+			m_pDiffuseTexture = pTexture;
+			m_pEffect->SetDiffuseMap(pTexture.get());
 		}
 
-		void SetGlossiness(const Texture* pTexture) const
+		void SetNormal(const std::shared_ptr<Texture>& pTexture)
 		{
-			m_pEffect->SetGlossinessMap(pTexture);
+			m_pNormalTexture = pTexture;
+			m_pEffect->SetNormalMap(pTexture.get());
 		}
 
-		void SetWorldMatrix() const
+		void SetSpecular(const std::shared_ptr<Texture>& pTexture)
 		{
-			m_pEffect->SetWorldMatrix(m_WorldMatrix);
+			m_pSpecularTexture = pTexture;
+			m_pEffect->SetSpecularMap(pTexture.get());
 		}
 
-		Matrix& GetWorldMatrix() { return m_WorldMatrix; }
-
-		void SetInvViewMatrix(const Matrix& invViewMatrix) const
+		void SetGlossiness(const std::shared_ptr<Texture>& pTexture)
 		{
-			m_pEffect->SetInvViewMatrix(invViewMatrix);
+			m_pGlossinessTexture = pTexture;
+			m_pEffect->SetGlossinessMap(pTexture.get());
 		}
 
+		const Matrix& GetWorldMatrix() const { return m_WorldMatrix; }
+		const Matrix& GetWorldViewProjectionMatrix() const { return m_WorldViewProjectionMatrix; }
+
 		void ToggleSamplerState(ID3D11Device* pDevice) const
 		{
 			m_pEffect->ToggleSamplerState(pDevice);
@@ -74,10 +85,34 @@ namespace dae
 		void SetRotationY(const float angle)
 		{
 			m_WorldMatrix = m_WorldMatrix * Matrix::CreateRotationY(angle) ;
+			++m_WorldVersion;
 		}
 
-		std::vector<Vertex>& GetVertices() { return m_Vertices; }
-		std::vector<uint32_t>& GetIndices() { return m_Indices; }
+		//changes every time the world matrix does, lets the users of the matrix skip the frames it stayed the same
+		uint32_t GetWorldVersion() const { return m_WorldVersion; }
+
+		std::span<const Vertex> GetVertices() const { return m_Data.vertices; }
+		std::span<const PackedVertex> GetPackedVertices() const { return m_Data.packedVertices; }
+
+		//maps the unorm positions of the packed vertices into object space
+		const Matrix& GetDequantizationMatrix() const { return m_DequantizationMatrix; }
+		std::span<const uint32_t> GetIndices() const { return m_Data.indices; }
+		std::span<const Meshlet> GetMeshlets() const { return m_Data.meshlets; }
+
+		std::span<const MeshLod> GetLods() const { return m_Data.lods; }
+		uint32_t GetLodIndex() const { return m_LodIndex; }
+		const MeshLod& GetLod() const { return m_Data.lods[m_LodIndex]; }
+
+		const MeshLod& GetLod(uint32_t lodIndex) const { return m_Data.lods[lodIndex]; }
+
+		void SetLodIndex(uint32_t lodIndex) { m_LodIndex = std::min(lodIndex, static_cast<uint32_t>(m_Data.lods.size()) - 1); }
+
+		//coarsest lod whose error covers at most maxPixelError pixels when the mesh is placed with worldMatrix, pixelsPerUnit is the screen size of one unit at distance 1
+		//a coarser lod than currentLod is only taken once it is below (1 - hysteresis) * maxPixelError, so the lod does not flicker around the threshold
+		uint32_t SelectLod(const Matrix& worldMatrix, uint32_t currentLod, const Vector3& cameraOrigin, float pixelsPerUnit, float maxPixelError, float hysteresis) const;
+
+		//box around the vertices in object space
+		const VertexQuantization::Bounds& GetBounds() const { return m_Data.bounds; }
 
 		PrimitiveTopology GetPrimitiveTopology() const { return m_PrimitiveTopology; }
 
@@ -91,14 +126,30 @@ namespace dae
 		ID3D11InputLayout* m_pInputLayout{};
 		ID3D11Buffer* m_pIndexBuffer{};
 
-		std::vector<Vertex> m_Vertices{};
-		std::vector<uint32_t> m_Indices{};
+		//vertices and indices, mapped from the mesh cache or freshly compiled
+		//the packed vertices are what is rendered, both by the input assembler and the software rasterizer
+		MeshData m_Data{};
+		Matrix m_DequantizationMatrix{};
 
 		uint32_t m_NumIndices{};
 
+		uint32_t m_LodIndex{};
+
 		Matrix m_WorldMatrix{};
+		Matrix m_WorldViewProjectionMatrix{};
+
+		//versions of the world matrix and the camera the effect matrices were built from
+		uint32_t m_WorldVersion{};
+		uint32_t m_UploadedWorldVersion{ UINT32_MAX };
+		uint32_t m_UploadedCameraVersion{ UINT32_MAX };
 
 		PrimitiveTopology m_PrimitiveTopology{ PrimitiveTopology::TriangleList };
 
+		//the effect only holds the views, keep the textures alive as long as they are bound
+		std::shared_ptr<Texture> m_pDiffuseTexture{};
+		std::shared_ptr<Texture> m_pNormalTexture{};
+		std::shared_ptr<Texture> m_pSpecularTexture{};
+		std::shared_ptr<Texture> m_pGlossinessTexture{};
+
 	};
 }
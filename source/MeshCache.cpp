@@ -0,0 +1,234 @@
+#include "pch.h"
+#include "MeshCache.h"
+#include "Utils.h"
+#include "Windows.h"
+#include <filesystem>
+#include <fstream>
+
+namespace dae
+{
+	namespace
+	{
+		//owns the buffers of a mesh compiled on a cache miss
+		struct CompiledBuffers
+		{
+			std::vector<Vertex> vertices{};
+			std::vector<uint32_t> indices{};
+			std::vector<PackedVertex> packedVertices{};
+			std::vector<Meshlet> meshlets{};
+			std::vector<MeshLod> lods{};
+		};
+	}
+
+	MeshData MeshCache::Load(const std::string& sourcePath, bool optimize)
+	{
+		std::error_code error{};
+
+		//key of the cache entry: path, size and last write time of the source, the layout of the vertices and the passes that ran
+		Header header{};
+		header.magic = m_Magic;
+		header.version = m_Version;
+		header.sourceSize = std::filesystem::file_size(sourcePath, error);
+		header.sourceTime = std::filesystem::last_write_time(sourcePath, error).time_since_epoch().count();
+		header.vertexSize = sizeof(Vertex);
+		header.packedVertexSize = sizeof(PackedVertex);
+		header.meshletSize = sizeof(Meshlet);
+		header.lodSize = sizeof(MeshLod);
+		header.isOptimized = optimize;
+
+		const std::string cachePath{ GetCachePath(sourcePath) };
+
+		if (!error)
+		{
+			if (MeshData cached{ Map(cachePath, header) }; cached.pStorage != nullptr)
+			{
+				++m_Hits;
+				return cached;
+			}
+		}
+
+		++m_Misses;
+
+		//cold path, parse the obj and run the load time passes
+		MeshData compiled{ Compile(sourcePath, optimize) };
+
+		if (!error && compiled.pStorage != nullptr) Store(cachePath, header, compiled);
+
+		return compiled;
+	}
+
+	std::string MeshCache::GetCachePath(const std::string& sourcePath)
+	{
+		//flatten the source path into a single file name inside the cache folder
+		std::string fileName{ sourcePath };
+		std::replace(fileName.begin(), fileName.end(), '/', '_');
+		std::replace(fileName.begin(), fileName.end(), '\\', '_');
+
+		return "Resources/Cache/" + fileName + ".mesh";
+	}
+
+	MeshData MeshCache::Map(const std::string& cachePath, const Header& expected)
+	{
+		const HANDLE file{ CreateFileA(cachePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr) };
+
+		if (file == INVALID_HANDLE_VALUE) return {};
+
+		LARGE_INTEGER fileSize{};
+		GetFileSizeEx(file, &fileSize);
+
+		if (static_cast<uint64_t>(fileSize.QuadPart) < sizeof(Header))
+		{
+			CloseHandle(file);
+			return {};
+		}
+
+		const HANDLE mapping{ CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) };
+
+		CloseHandle(file);
+
+		if (mapping == nullptr) return {};
+
+		//the view keeps the file alive, the handles are not needed anymore
+		const void* pView{ MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) };
+
+		CloseHandle(mapping);
+
+		if (pView == nullptr) return {};
+
+		//unmapped when the last span user lets go of the storage
+		std::shared_ptr<const void> pStorage{ pView, [](const void* pMappedView) { UnmapViewOfFile(pMappedView); } };
+
+		const Header& header{ *static_cast<const Header*>(pView) };
+
+		const uint64_t vertexBytes{ uint64_t{ header.nrOfVertices } * sizeof(Vertex) };
+		const uint64_t packedVertexBytes{ uint64_t{ header.nrOfVertices } * sizeof(PackedVertex) };
+		const uint64_t indexBytes{ uint64_t{ header.nrOfIndices } * sizeof(uint32_t) };
+		const uint64_t meshletBytes{ uint64_t{ header.nrOfMeshlets } * sizeof(Meshlet) };
+		const uint64_t lodBytes{ uint64_t{ header.nrOfLods } * sizeof(MeshLod) };
+
+		const bool isValid
+		{
+			header.magic == expected.magic &&
+			header.version == expected.version &&
+			header.sourceSize == expected.sourceSize &&
+			header.sourceTime == expected.sourceTime &&
+			header.vertexSize == expected.vertexSize &&
+			header.packedVertexSize == expected.packedVertexSize &&
+			header.meshletSize == expected.meshletSize &&
+			header.lodSize == expected.lodSize &&
+			header.isOptimized == expected.isOptimized &&
+			header.fileSize == static_cast<uint64_t>(fileSize.QuadPart) &&
+			header.vertexOffset + vertexBytes <= header.fileSize &&
+			header.packedVertexOffset + packedVertexBytes <= header.fileSize &&
+			header.indexOffset + indexBytes <= header.fileSize &&
+			header.meshletOffset + meshletBytes <= header.fileSize &&
+			header.lodOffset + lodBytes <= header.fileSize
+		};
+
+		if (!isValid) return {};
+
+		const uint8_t* pBytes{ static_cast<const uint8_t*>(pView) };
+
+		MeshData data{};
+		data.vertices = { reinterpret_cast<const Vertex*>(pBytes + header.vertexOffset), header.nrOfVertices };
+		data.packedVertices = { reinterpret_cast<const PackedVertex*>(pBytes + header.packedVertexOffset), header.nrOfVertices };
+		data.indices = { reinterpret_cast<const uint32_t*>(pBytes + header.indexOffset), header.nrOfIndices };
+		data.meshlets = { reinterpret_cast<const Meshlet*>(pBytes + header.meshletOffset), header.nrOfMeshlets };
+		data.lods = { reinterpret_cast<const MeshLod*>(pBytes + header.lodOffset), header.nrOfLods };
+		data.bounds = { header.boundsMin, header.boundsExtent };
+		data.statistics = header.statistics;
+		data.pStorage = std::move(pStorage);
+
+		return data;
+	}
+
+	MeshData MeshCache::Compile(const std::string& sourcePath, bool optimize)
+	{
+		const std::shared_ptr<CompiledBuffers> pBuffers{ std::make_shared<CompiledBuffers>() };
+
+		if (!Utils::ParseOBJ(sourcePath, pBuffers->vertices, pBuffers->indices)) return {};
+
+		MeshData data{};
+
+		if (optimize)
+		{
+			data.statistics = MeshOptimizer::Optimize(pBuffers->vertices, pBuffers->indices);
+
+			pBuffers->meshlets = MeshOptimizer::BuildMeshlets(pBuffers->vertices, pBuffers->indices);
+
+			data.statistics.nrOfMeshlets = pBuffers->meshlets.size();
+			data.statistics.nrOfMeshletVertices = pBuffers->vertices.size();
+
+			//the simplified lods are appended behind the full detail mesh
+			pBuffers->lods = MeshOptimizer::BuildLods(pBuffers->vertices, pBuffers->indices);
+		}
+		else
+		{
+			data.statistics.nrOfParsedVertices = data.statistics.nrOfVertices = pBuffers->vertices.size();
+			data.statistics.fileOrderACMR = data.statistics.optimizedACMR = MeshOptimizer::CalculateACMR(pBuffers->indices, pBuffers->vertices.size());
+
+			pBuffers->lods = { MeshLod{ 0, static_cast<uint32_t>(pBuffers->indices.size()), 0, static_cast<uint32_t>(pBuffers->vertices.size()), 0.f } };
+		}
+
+		pBuffers->packedVertices = VertexQuantization::Pack(pBuffers->vertices, data.bounds);
+
+		data.vertices = pBuffers->vertices;
+		data.packedVertices = pBuffers->packedVertices;
+		data.indices = pBuffers->indices;
+		data.meshlets = pBuffers->meshlets;
+		data.lods = pBuffers->lods;
+		data.pStorage = pBuffers;
+
+		return data;
+	}
+
+	void MeshCache::Store(const std::string& cachePath, Header header, const MeshData& data)
+	{
+		std::error_code error{};
+		std::filesystem::create_directories(std::filesystem::path{ cachePath }.parent_path(), error);
+
+		header.nrOfVertices = static_cast<uint32_t>(data.vertices.size());
+		header.nrOfIndices = static_cast<uint32_t>(data.indices.size());
+		header.nrOfMeshlets = static_cast<uint32_t>(data.meshlets.size());
+		header.nrOfLods = static_cast<uint32_t>(data.lods.size());
+		header.vertexOffset = AlignSection(sizeof(Header));
+		header.packedVertexOffset = AlignSection(header.vertexOffset + data.vertices.size_bytes());
+		header.indexOffset = AlignSection(header.packedVertexOffset + data.packedVertices.size_bytes());
+		header.meshletOffset = AlignSection(header.indexOffset + data.indices.size_bytes());
+		header.lodOffset = AlignSection(header.meshletOffset + data.meshlets.size_bytes());
+		header.fileSize = header.lodOffset + data.lods.size_bytes();
+		header.boundsMin = data.bounds.min;
+		header.boundsExtent = data.bounds.extent;
+		header.statistics = data.statistics;
+
+		//write to a temporary file first so a concurrent or interrupted run never sees half a file
+		const std::string tempPath{ cachePath + ".tmp" };
+
+		{
+			std::ofstream file{ tempPath, std::ios::binary | std::ios::trunc };
+
+			if (!file) return;
+
+			const auto writeSection = [&file](uint64_t offset, const void* pData, size_t size)
+			{
+				//pad up to the start of the section
+				static constexpr char padding[m_SectionAlignment]{};
+				file.write(padding, static_cast<std::streamsize>(offset - static_cast<uint64_t>(file.tellp())));
+
+				file.write(static_cast<const char*>(pData), static_cast<std::streamsize>(size));
+			};
+
+			file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+
+			writeSection(header.vertexOffset, data.vertices.data(), data.vertices.size_bytes());
+			writeSection(header.packedVertexOffset, data.packedVertices.data(), data.packedVertices.size_bytes());
+			writeSection(header.indexOffset, data.indices.data(), data.indices.size_bytes());
+			writeSection(header.meshletOffset, data.meshlets.data(), data.meshlets.size_bytes());
+			writeSection(header.lodOffset, data.lods.data(), data.lods.size_bytes());
+
+			if (!file) return;
+		}
+
+		std::filesystem::rename(tempPath, cachePath, error);
+	}
+}
@@ -0,0 +1,106 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include "DataTypes.h"
+#include "MeshOptimizer.h"
+#include "VertexQuantization.h"
+
+namespace dae
+{
+	//compiled mesh, the spans point into a mapped cache file or into the buffers of a freshly compiled mesh
+	struct MeshData
+	{
+		//full precision welded vertices, for the cpu side tools
+		std::span<const Vertex> vertices{};
+
+		//what is rendered
+		std::span<const PackedVertex> packedVertices{};
+		VertexQuantization::Bounds bounds{};
+
+		std::span<const uint32_t> indices{};
+
+		//only built for optimized meshes, empty otherwise
+		std::span<const Meshlet> meshlets{};
+
+		//finest first, the first lod is the whole mesh the meshlets are cut from
+		std::span<const MeshLod> lods{};
+
+		MeshOptimizer::Statistics statistics{};
+
+		//keeps the memory behind the spans alive
+		std::shared_ptr<const void> pStorage{};
+	};
+
+	//stores parsed, optimized and quantized meshes in a binary file next to the resources
+	//a warm cache is memory mapped and handed out without copying, the obj is only parsed on a miss
+	class MeshCache final
+	{
+	public:
+
+		//optimize welds and reorders the triangles and builds the meshlets and lods (MeshOptimizer), leave it off for meshes whose triangle order matters
+		static MeshData Load(const std::string& sourcePath, bool optimize);
+
+		static uint32_t GetHits() { return m_Hits; }
+		static uint32_t GetMisses() { return m_Misses; }
+
+	private:
+
+		struct Header
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint64_t sourceSize;
+			int64_t sourceTime;
+
+			//layout of the stored vertices, a changed struct invalidates the cache
+			uint32_t vertexSize;
+			uint32_t packedVertexSize;
+			uint32_t meshletSize;
+			uint32_t lodSize;
+			uint32_t isOptimized;
+
+			uint32_t nrOfVertices;
+			uint32_t nrOfIndices;
+			uint32_t nrOfMeshlets;
+			uint32_t nrOfLods;
+
+			//byte offsets of the sections, every section starts on a cache line
+			uint64_t vertexOffset;
+			uint64_t packedVertexOffset;
+			uint64_t indexOffset;
+			uint64_t meshletOffset;
+			uint64_t lodOffset;
+			uint64_t fileSize;
+
+			Vector3 boundsMin;
+			Vector3 boundsExtent;
+
+			MeshOptimizer::Statistics statistics;
+		};
+
+		static constexpr uint32_t m_Magic{ 0x4853454D }; // "MESH"
+		static constexpr uint32_t m_Version{ 3 };
+
+		static constexpr uint64_t m_SectionAlignment{ 64 };
+
+		static inline std::atomic<uint32_t> m_Hits{};
+		static inline std::atomic<uint32_t> m_Misses{};
+
+		static std::string GetCachePath(const std::string& sourcePath);
+
+		static MeshData Map(const std::string& cachePath, const Header& expected);
+
+		//parses the obj and builds every section
+		static MeshData Compile(const std::string& sourcePath, bool optimize);
+
+		static void Store(const std::string& cachePath, Header header, const MeshData& data);
+
+		static uint64_t AlignSection(uint64_t offset)
+		{
+			return (offset + m_SectionAlignment - 1) & ~(m_SectionAlignment - 1);
+		}
+	};
+}
@@ -0,0 +1,1055 @@
+#include "pch.h"
+#include "MeshOptimizer.h"
+#include <bit>
+#include <numeric>
+#include <span>
+#include <unordered_map>
+
+namespace dae
+{
+	namespace MeshOptimizer
+	{
+		namespace
+		{
+			constexpr uint32_t noVertex{ UINT32_MAX };
+
+			//bits of the attributes that have to match for two vertices to be welded
+			struct WeldKey
+			{
+				uint32_t bits[8]{};
+
+				explicit WeldKey(const Vertex& vertex)
+					: bits
+					{
+						std::bit_cast<uint32_t>(vertex.position.x), std::bit_cast<uint32_t>(vertex.position.y), std::bit_cast<uint32_t>(vertex.position.z),
+						std::bit_cast<uint32_t>(vertex.normal.x), std::bit_cast<uint32_t>(vertex.normal.y), std::bit_cast<uint32_t>(vertex.normal.z),
+						std::bit_cast<uint32_t>(vertex.uv.x), std::bit_cast<uint32_t>(vertex.uv.y)
+					}
+				{
+				}
+
+				bool operator==(const WeldKey& other) const
+				{
+					return std::equal(std::begin(bits), std::end(bits), std::begin(other.bits));
+				}
+			};
+
+			struct WeldKeyHash
+			{
+				size_t operator()(const WeldKey& key) const
+				{
+					//fnv-1a over the bits
+					uint64_t hash{ 14695981039346656037ull };
+
+					for (const uint32_t bits : key.bits)
+					{
+						hash = (hash ^ bits) * 1099511628211ull;
+					}
+
+					return static_cast<size_t>(hash);
+				}
+			};
+
+			//fifo cache where a vertex is cached while less than cacheSize misses happened since it was loaded
+			struct CacheSimulation
+			{
+				std::vector<uint32_t> timestamps;
+				uint32_t timestamp;
+				uint32_t cacheSize;
+
+				CacheSimulation(size_t nrOfVertices, uint32_t size)
+					: timestamps(nrOfVertices, 0)
+					, timestamp{ size + 1 }
+					, cacheSize{ size }
+				{
+				}
+
+				bool IsCached(uint32_t vertex) const
+				{
+					return timestamp - timestamps[vertex] <= cacheSize;
+				}
+
+				//returns the number of misses (0 or 1)
+				uint32_t Access(uint32_t vertex)
+				{
+					if (IsCached(vertex)) return 0;
+
+					timestamps[vertex] = timestamp++;
+					return 1;
+				}
+
+				void Flush()
+				{
+					timestamp += cacheSize + 1;
+				}
+			};
+
+			//sum of squared distances to a set of planes, weighted by the area of the triangles they came from
+			struct Quadric
+			{
+				//symmetric a (n * n), b (n * d), c (d * d)
+				double a00{}, a11{}, a22{}, a10{}, a20{}, a21{};
+				double b0{}, b1{}, b2{};
+				double c{};
+				double weight{};
+
+				static Quadric FromPlane(const Vector3& normal, float distance, float area)
+				{
+					const double nx{ normal.x }, ny{ normal.y }, nz{ normal.z }, d{ distance };
+
+					return Quadric
+					{
+						nx * nx * area, ny * ny * area, nz * nz * area, ny * nx * area, nz * nx * area, nz * ny * area,
+						nx * d * area, ny * d * area, nz * d * area,
+						d * d * area,
+						area
+					};
+				}
+
+				Quadric& operator+=(const Quadric& other)
+				{
+					a00 += other.a00; a11 += other.a11; a22 += other.a22; a10 += other.a10; a20 += other.a20; a21 += other.a21;
+					b0 += other.b0; b1 += other.b1; b2 += other.b2;
+					c += other.c;
+					weight += other.weight;
+
+					return *this;
+				}
+
+				//mean squared distance of p to the planes
+				double Error(const Vector3& p) const
+				{
+					const double x{ p.x }, y{ p.y }, z{ p.z };
+
+					const double error
+					{
+						a00 * x * x + a11 * y * y + a22 * z * z + 2.0 * (a10 * x * y + a20 * x * z + a21 * y * z) +
+						2.0 * (b0 * x + b1 * y + b2 * z) + c
+					};
+
+					return weight > 0.0 ? std::abs(error) / weight : 0.0;
+				}
+			};
+
+			struct Collapse
+			{
+				uint32_t from;
+				uint32_t to;
+				double error;
+			};
+		}
+
+		Statistics Optimize(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, uint32_t cacheSize)
+		{
+			Statistics statistics{};
+			statistics.nrOfParsedVertices = vertices.size();
+
+			WeldVertices(vertices, indices);
+
+			statistics.nrOfVertices = vertices.size();
+			statistics.fileOrderACMR = CalculateACMR(indices, vertices.size(), cacheSize);
+
+			std::vector<uint32_t> clusters{};
+			OptimizeVertexCache(indices, vertices.size(), clusters, cacheSize);
+			OptimizeOverdraw(indices, vertices, clusters, 1.05f, cacheSize);
+
+			statistics.optimizedACMR = CalculateACMR(indices, vertices.size(), cacheSize);
+
+			return statistics;
+		}
+
+		void WeldVertices(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+		{
+			//welded vertices per key, a key can hold more than one when the tangents point in opposite directions (mirrored uvs)
+			std::unordered_map<WeldKey, std::vector<uint32_t>, WeldKeyHash> weldedVertices{};
+			weldedVertices.reserve(vertices.size());
+
+			std::vector<Vertex> welded{};
+			welded.reserve(vertices.size());
+
+			std::vector<uint32_t> remap(vertices.size());
+
+			for (size_t idx{}; idx < vertices.size(); ++idx)
+			{
+				const Vertex& vertex{ vertices[idx] };
+				std::vector<uint32_t>& candidates{ weldedVertices[WeldKey{ vertex }] };
+
+				uint32_t target{ noVertex };
+
+				for (const uint32_t candidate : candidates)
+				{
+					if (Vector3::Dot(welded[candidate].tangent, vertex.tangent) > 0.f)
+					{
+						target = candidate;
+						break;
+					}
+				}
+
+				if (target == noVertex)
+				{
+					target = static_cast<uint32_t>(welded.size());
+					candidates.push_back(target);
+					welded.push_back(vertex);
+				}
+				else
+				{
+					//accumulate, normalized below
+					welded[target].tangent += vertex.tangent;
+				}
+
+				remap[idx] = target;
+			}
+
+			for (Vertex& vertex : welded)
+			{
+				vertex.tangent = Vector3::Reject(vertex.tangent, vertex.normal).Normalized();
+			}
+
+			for (uint32_t& index : indices)
+			{
+				index = remap[index];
+			}
+
+			vertices = std::move(welded);
+		}
+
+		void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t nrOfVertices, std::vector<uint32_t>& clusters, uint32_t cacheSize)
+		{
+			const size_t nrOfTriangles{ indices.size() / 3 };
+
+			clusters.clear();
+
+			if (nrOfTriangles == 0) return;
+
+			//triangles using every vertex
+			std::vector<uint32_t> adjacencyOffsets(nrOfVertices + 1, 0);
+
+			for (const uint32_t index : indices)
+			{
+				++adjacencyOffsets[index + 1];
+			}
+
+			std::partial_sum(adjacencyOffsets.begin(), adjacencyOffsets.end(), adjacencyOffsets.begin());
+
+			std::vector<uint32_t> adjacency(indices.size());
+			std::vector<uint32_t> fillOffsets(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+
+			for (size_t idx{}; idx < indices.size(); ++idx)
+			{
+				adjacency[fillOffsets[indices[idx]]++] = static_cast<uint32_t>(idx / 3);
+			}
+
+			//triangles of every vertex that still have to be emitted
+			std::vector<uint32_t> liveTriangles(nrOfVertices);
+
+			for (size_t vertex{}; vertex < nrOfVertices; ++vertex)
+			{
+				liveTriangles[vertex] = adjacencyOffsets[vertex + 1] - adjacencyOffsets[vertex];
+			}
+
+			CacheSimulation cache{ nrOfVertices, cacheSize };
+
+			std::vector<uint8_t> isEmitted(nrOfTriangles, 0);
+
+			//recently used vertices, the next fan starts here when no candidate is left
+			std::vector<uint32_t> deadEnd{};
+			deadEnd.reserve(indices.size());
+
+			std::vector<uint32_t> candidates{};
+
+			std::vector<uint32_t> output{};
+			output.reserve(indices.size());
+
+			uint32_t cursor{};
+
+			const auto skipDeadEnd = [&]() -> uint32_t
+			{
+				while (!deadEnd.empty())
+				{
+					const uint32_t vertex{ deadEnd.back() };
+					deadEnd.pop_back();
+
+					if (liveTriangles[vertex] > 0) return vertex;
+				}
+
+				//nothing recent left, continue in input order
+				for (; cursor < nrOfVertices; ++cursor)
+				{
+					if (liveTriangles[cursor] > 0) return cursor;
+				}
+
+				return noVertex;
+			};
+
+			uint32_t fanningVertex{ skipDeadEnd() };
+			clusters.push_back(0);
+
+			while (fanningVertex != noVertex)
+			{
+				candidates.clear();
+
+				//emit every remaining triangle around the fanning vertex
+				for (uint32_t adjacencyIdx{ adjacencyOffsets[fanningVertex] }; adjacencyIdx < adjacencyOffsets[fanningVertex + 1]; ++adjacencyIdx)
+				{
+					const uint32_t triangle{ adjacency[adjacencyIdx] };
+
+					if (isEmitted[triangle]) continue;
+
+					for (uint32_t corner{}; corner < 3; ++corner)
+					{
+						const uint32_t vertex{ indices[triangle * 3 + corner] };
+
+						output.push_back(vertex);
+						deadEnd.push_back(vertex);
+						candidates.push_back(vertex);
+
+						--liveTriangles[vertex];
+						cache.Access(vertex);
+					}
+
+					isEmitted[triangle] = 1;
+				}
+
+				//next fan: the oldest candidate that is still cached after its remaining triangles are emitted
+				uint32_t nextVertex{ noVertex };
+				int bestPriority{ -1 };
+
+				for (const uint32_t vertex : candidates)
+				{
+					if (liveTriangles[vertex] == 0) continue;
+
+					const uint32_t age{ cache.timestamp - cache.timestamps[vertex] };
+					const int priority{ age + 2 * liveTriangles[vertex] <= cacheSize ? static_cast<int>(age) : 0 };
+
+					if (priority > bestPriority)
+					{
+						bestPriority = priority;
+						nextVertex = vertex;
+					}
+				}
+
+				//no neighbour left, the next fan does not continue the current one
+				if (nextVertex == noVertex)
+				{
+					nextVertex = skipDeadEnd();
+
+					if (nextVertex != noVertex) clusters.push_back(static_cast<uint32_t>(output.size() / 3));
+				}
+
+				fanningVertex = nextVertex;
+			}
+
+			indices = std::move(output);
+		}
+
+		void OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& clusters, float threshold, uint32_t cacheSize)
+		{
+			const size_t nrOfTriangles{ indices.size() / 3 };
+
+			if (nrOfTriangles == 0 || clusters.empty()) return;
+
+			CacheSimulation cache{ vertices.size(), cacheSize };
+
+			const auto triangleMisses = [&](size_t triangle)
+			{
+				return cache.Access(indices[triangle * 3]) + cache.Access(indices[triangle * 3 + 1]) + cache.Access(indices[triangle * 3 + 2]);
+			};
+
+			//split every cluster where the ACMR of the part so far is close enough to the ACMR of the whole cluster
+			std::vector<uint32_t> splitClusters{};
+
+			for (size_t clusterIdx{}; clusterIdx < clusters.size(); ++clusterIdx)
+			{
+				const size_t begin{ clusters[clusterIdx] };
+				const size_t end{ clusterIdx + 1 < clusters.size() ? clusters[clusterIdx + 1] : nrOfTriangles };
+
+				cache.Flush();
+
+				uint32_t clusterMisses{};
+
+				for (size_t triangle{ begin }; triangle < end; ++triangle)
+				{
+					clusterMisses += triangleMisses(triangle);
+				}
+
+				const float maxACMR{ threshold * static_cast<float>(clusterMisses) / static_cast<float>(end - begin) };
+
+				cache.Flush();
+				splitClusters.push_back(static_cast<uint32_t>(begin));
+
+				uint32_t misses{};
+				size_t splitBegin{ begin };
+
+				for (size_t triangle{ begin }; triangle < end; ++triangle)
+				{
+					misses += triangleMisses(triangle);
+
+					if (triangle + 1 < end && static_cast<float>(misses) <= maxACMR * static_cast<float>(triangle + 1 - splitBegin))
+					{
+						splitBegin = triangle + 1;
+						splitClusters.push_back(static_cast<uint32_t>(splitBegin));
+
+						misses = 0;
+						cache.Flush();
+					}
+				}
+			}
+
+			//area weighted centroid and normal of every cluster and of the mesh
+			struct Cluster
+			{
+				uint32_t begin{};
+				uint32_t end{};
+				Vector3 centroid{};
+				Vector3 normal{};
+				float sortKey{};
+			};
+
+			std::vector<Cluster> sortedClusters(splitClusters.size());
+
+			Vector3 meshCentroid{};
+			float meshArea{};
+
+			for (size_t clusterIdx{}; clusterIdx < splitClusters.size(); ++clusterIdx)
+			{
+				Cluster& cluster{ sortedClusters[clusterIdx] };
+				cluster.begin = splitClusters[clusterIdx];
+				cluster.end = clusterIdx + 1 < splitClusters.size() ? splitClusters[clusterIdx + 1] : static_cast<uint32_t>(nrOfTriangles);
+
+				float clusterArea{};
+
+				for (uint32_t triangle{ cluster.begin }; triangle < cluster.end; ++triangle)
+				{
+					const Vertex& v0{ vertices[indices[triangle * 3]] };
+					const Vertex& v1{ vertices[indices[triangle * 3 + 1]] };
+					const Vertex& v2{ vertices[indices[triangle * 3 + 2]] };
+
+					//twice the area, oriented along the shading normals so the winding does not matter
+					Vector3 normal{ Vector3::Cross(v1.position - v0.position, v2.position - v0.position) };
+
+					if (Vector3::Dot(normal, v0.normal + v1.normal + v2.normal) < 0.f) normal = -normal;
+
+					const float area{ normal.Magnitude() };
+
+					cluster.centroid += (v0.position + v1.position + v2.position) * (area / 3.f);
+					cluster.normal += normal;
+					clusterArea += area;
+				}
+
+				meshCentroid += cluster.centroid;
+				meshArea += clusterArea;
+
+				if (clusterArea > 0.f) cluster.centroid /= clusterArea;
+			}
+
+			if (meshArea > 0.f) meshCentroid /= meshArea;
+
+			for (Cluster& cluster : sortedClusters)
+			{
+				const float normalLength{ cluster.normal.Magnitude() };
+
+				cluster.sortKey = normalLength > 0.f ? Vector3::Dot(cluster.centroid - meshCentroid, cluster.normal) / normalLength : 0.f;
+			}
+
+			//outermost clusters first
+			std::stable_sort(sortedClusters.begin(), sortedClusters.end(), [](const Cluster& a, const Cluster& b) { return a.sortKey > b.sortKey; });
+
+			std::vector<uint32_t> output{};
+			output.reserve(indices.size());
+
+			for (const Cluster& cluster : sortedClusters)
+			{
+				output.insert(output.end(), indices.begin() + cluster.begin * 3, indices.begin() + cluster.end * 3);
+			}
+
+			indices = std::move(output);
+		}
+
+		std::vector<Meshlet> BuildMeshlets(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, uint32_t maxVertices, uint32_t maxTriangles)
+		{
+			const size_t nrOfTriangles{ indices.size() / 3 };
+
+			//the cone has to follow the winding the rasterizer culls with, find which side of it the shading normals are on
+			float windingSign{};
+
+			for (size_t triangle{}; triangle < nrOfTriangles; ++triangle)
+			{
+				const Vertex& v0{ vertices[indices[triangle * 3]] };
+				const Vertex& v1{ vertices[indices[triangle * 3 + 1]] };
+				const Vertex& v2{ vertices[indices[triangle * 3 + 2]] };
+
+				windingSign += Vector3::Dot(Vector3::Cross(v1.position - v0.position, v2.position - v0.position), v0.normal + v1.normal + v2.normal);
+			}
+
+			windingSign = windingSign < 0.f ? -1.f : 1.f;
+
+			std::vector<Meshlet> meshlets{};
+
+			std::vector<Vertex> meshletVertices{};
+			meshletVertices.reserve(vertices.size());
+
+			std::vector<uint32_t> meshletIndices{};
+			meshletIndices.reserve(indices.size());
+
+			//index of every source vertex inside the current meshlet
+			std::vector<uint32_t> localVertices(vertices.size(), noVertex);
+			std::vector<uint32_t> usedVertices{};
+
+			Meshlet meshlet{};
+
+			const auto finishMeshlet = [&]()
+			{
+				if (meshlet.triangleCount == 0) return;
+
+				const std::span<const Vertex> ownVertices{ meshletVertices.data() + meshlet.vertexOffset, meshlet.vertexCount };
+
+				//sphere around the center of the box
+				Vector3 minPosition{ ownVertices[0].position };
+				Vector3 maxPosition{ ownVertices[0].position };
+
+				for (const Vertex& vertex : ownVertices)
+				{
+					minPosition = Vector3{ std::min(minPosition.x, vertex.position.x), std::min(minPosition.y, vertex.position.y), std::min(minPosition.z, vertex.position.z) };
+					maxPosition = Vector3{ std::max(maxPosition.x, vertex.position.x), std::max(maxPosition.y, vertex.position.y), std::max(maxPosition.z, vertex.position.z) };
+				}
+
+				meshlet.center = (minPosition + maxPosition) * 0.5f;
+
+				for (const Vertex& vertex : ownVertices)
+				{
+					meshlet.radius = std::max(meshlet.radius, (vertex.position - meshlet.center).Magnitude());
+				}
+
+				//cone around the average face normal
+				std::vector<Vector3> faceNormals{};
+				faceNormals.reserve(meshlet.triangleCount);
+
+				Vector3 axis{};
+
+				for (uint32_t triangle{ meshlet.triangleOffset }; triangle < meshlet.triangleOffset + meshlet.triangleCount; ++triangle)
+				{
+					const Vector3& p0{ meshletVertices[meshletIndices[triangle * 3]].position };
+					const Vector3& p1{ meshletVertices[meshletIndices[triangle * 3 + 1]].position };
+					const Vector3& p2{ meshletVertices[meshletIndices[triangle * 3 + 2]].position };
+
+					const Vector3 normal{ Vector3::Cross(p1 - p0, p2 - p0) * windingSign };
+					const float length{ normal.Magnitude() };
+
+					//degenerate triangles are never rasterized
+					if (length <= 0.f) continue;
+
+					faceNormals.push_back(normal / length);
+					axis += faceNormals.back();
+				}
+
+				const float axisLength{ axis.Magnitude() };
+
+				if (axisLength > 0.f)
+				{
+					meshlet.coneAxis = axis / axisLength;
+
+					float minDot{ 1.f };
+
+					for (const Vector3& normal : faceNormals)
+					{
+						minDot = std::min(minDot, Vector3::Dot(normal, meshlet.coneAxis));
+					}
+
+					//a spread of 90 degrees or more always has a triangle facing the camera
+					meshlet.coneCutoff = minDot > 0.f ? std::sqrt(1.f - minDot * minDot) : 1.f;
+				}
+
+				meshlets.push_back(meshlet);
+
+				for (const uint32_t vertex : usedVertices)
+				{
+					localVertices[vertex] = noVertex;
+				}
+
+				usedVertices.clear();
+
+				meshlet = Meshlet{};
+				meshlet.triangleOffset = static_cast<uint32_t>(meshletIndices.size() / 3);
+				meshlet.vertexOffset = static_cast<uint32_t>(meshletVertices.size());
+			};
+
+			for (size_t triangle{}; triangle < nrOfTriangles; ++triangle)
+			{
+				uint32_t newVertices{};
+
+				for (uint32_t corner{}; corner < 3; ++corner)
+				{
+					newVertices += localVertices[indices[triangle * 3 + corner]] == noVertex;
+				}
+
+				if (meshlet.vertexCount + newVertices > maxVertices || meshlet.triangleCount + 1 > maxTriangles) finishMeshlet();
+
+				for (uint32_t corner{}; corner < 3; ++corner)
+				{
+					const uint32_t vertex{ indices[triangle * 3 + corner] };
+
+					if (localVertices[vertex] == noVertex)
+					{
+						localVertices[vertex] = static_cast<uint32_t>(meshletVertices.size());
+						usedVertices.push_back(vertex);
+
+						meshletVertices.push_back(vertices[vertex]);
+						++meshlet.vertexCount;
+					}
+
+					meshletIndices.push_back(localVertices[vertex]);
+				}
+
+				++meshlet.triangleCount;
+			}
+
+			finishMeshlet();
+
+			vertices = std::move(meshletVertices);
+			indices = std::move(meshletIndices);
+
+			return meshlets;
+		}
+
+		std::vector<uint32_t> Simplify(const std::vector<Vertex>& vertices, std::span<const uint32_t> indices, size_t targetIndexCount, float maxError, float& resultError)
+		{
+			resultError = 0.f;
+
+			//vertices the meshlets duplicated are the same vertex to the simplifier
+			std::unordered_map<WeldKey, std::vector<uint32_t>, WeldKeyHash> uniqueVertices{};
+			std::vector<uint32_t> remap(vertices.size(), noVertex);
+
+			//the edges are collapsed between positions, a position holds more than one vertex on a normal or uv seam
+			std::unordered_map<WeldKey, uint32_t, WeldKeyHash> positionIds{};
+			std::vector<uint32_t> vertexPositions(vertices.size(), noVertex);
+			std::vector<std::vector<uint32_t>> positionVertices{};
+
+			for (const uint32_t vertex : indices)
+			{
+				if (remap[vertex] != noVertex) continue;
+
+				const Vertex& source{ vertices[vertex] };
+
+				std::vector<uint32_t>& candidates{ uniqueVertices[WeldKey{ source }] };
+
+				const auto match = std::find_if(candidates.begin(), candidates.end(), [&](uint32_t candidate)
+				{
+					const Vector3& tangent{ vertices[candidate].tangent };
+					return std::bit_cast<uint32_t>(tangent.x) == std::bit_cast<uint32_t>(source.tangent.x) &&
+						std::bit_cast<uint32_t>(tangent.y) == std::bit_cast<uint32_t>(source.tangent.y) &&
+						std::bit_cast<uint32_t>(tangent.z) == std::bit_cast<uint32_t>(source.tangent.z);
+				});
+
+				if (match != candidates.end())
+				{
+					remap[vertex] = *match;
+					continue;
+				}
+
+				candidates.push_back(vertex);
+				remap[vertex] = vertex;
+
+				Vertex positionOnly{};
+				positionOnly.position = source.position;
+
+				const auto [it, isNew] { positionIds.try_emplace(WeldKey{ positionOnly }, static_cast<uint32_t>(positionVertices.size())) };
+
+				if (isNew) positionVertices.emplace_back();
+
+				vertexPositions[vertex] = it->second;
+				positionVertices[it->second].push_back(vertex);
+			}
+
+			const size_t nrOfPositions{ positionVertices.size() };
+
+			std::vector<uint32_t> result(indices.size());
+
+			for (size_t idx{}; idx < indices.size(); ++idx)
+			{
+				result[idx] = remap[indices[idx]];
+			}
+
+			const auto position = [&](uint32_t vertex) -> const Vector3& { return vertices[vertex].position; };
+
+			//an edge only used by one triangle lies on a border
+			std::unordered_map<uint64_t, uint32_t> edgeUses{};
+			edgeUses.reserve(result.size());
+
+			const auto edgeKey = [&](uint32_t a, uint32_t b)
+			{
+				const uint64_t positionA{ vertexPositions[a] };
+				const uint64_t positionB{ vertexPositions[b] };
+
+				return positionA < positionB ? (positionA << 32 | positionB) : (positionB << 32 | positionA);
+			};
+
+			//border positions slide along their two border edges, the ones where more borders meet are locked
+			std::vector<uint32_t> nrOfBorderEdges(nrOfPositions);
+
+			const auto classifyEdges = [&]()
+			{
+				edgeUses.clear();
+				std::fill(nrOfBorderEdges.begin(), nrOfBorderEdges.end(), 0);
+
+				for (size_t idx{}; idx < result.size(); idx += 3)
+				{
+					for (uint32_t corner{}; corner < 3; ++corner)
+					{
+						++edgeUses[edgeKey(result[idx + corner], result[idx + (corner + 1) % 3])];
+					}
+				}
+
+				for (const auto& [key, uses] : edgeUses)
+				{
+					if (uses != 1) continue;
+
+					++nrOfBorderEdges[key >> 32];
+					++nrOfBorderEdges[key & UINT32_MAX];
+				}
+			};
+
+			const auto canCollapse = [&](uint32_t from, bool isBorderEdge)
+			{
+				return nrOfBorderEdges[from] == 0 || (nrOfBorderEdges[from] == 2 && isBorderEdge);
+			};
+
+			classifyEdges();
+
+			//the planes of every triangle around a position
+			std::vector<Quadric> quadrics(nrOfPositions);
+
+			for (size_t idx{}; idx < result.size(); idx += 3)
+			{
+				const Vector3& p0{ position(result[idx]) };
+
+				const Vector3 cross{ Vector3::Cross(position(result[idx + 1]) - p0, position(result[idx + 2]) - p0) };
+				const float length{ cross.Magnitude() };
+
+				if (length <= 0.f) continue;
+
+				const Vector3 normal{ cross / length };
+				const Quadric plane{ Quadric::FromPlane(normal, -Vector3::Dot(normal, p0), length * 0.5f) };
+
+				for (uint32_t corner{}; corner < 3; ++corner)
+				{
+					const uint32_t a{ result[idx + corner] };
+					const uint32_t b{ result[idx + (corner + 1) % 3] };
+
+					quadrics[vertexPositions[a]] += plane;
+
+					//a plane standing on the border edge keeps the border from sliding into the surface
+					if (edgeUses[edgeKey(a, b)] != 1) continue;
+
+					const Vector3 edge{ position(b) - position(a) };
+					const Vector3 borderNormal{ Vector3::Cross(edge, normal) };
+					const float borderLength{ borderNormal.Magnitude() };
+
+					if (borderLength <= 0.f) continue;
+
+					const Vector3 borderPlaneNormal{ borderNormal / borderLength };
+					const Quadric borderPlane{ Quadric::FromPlane(borderPlaneNormal, -Vector3::Dot(borderPlaneNormal, position(a)), edge.SqrMagnitude()) };
+
+					quadrics[vertexPositions[a]] += borderPlane;
+					quadrics[vertexPositions[b]] += borderPlane;
+				}
+			}
+
+			const double maxSquaredError{ static_cast<double>(maxError) * maxError };
+
+			std::vector<Collapse> collapses{};
+			std::vector<uint32_t> triangleOffsets(vertices.size() + 1);
+			std::vector<uint32_t> vertexTriangles{};
+			std::vector<uint32_t> fillOffsets{};
+			std::vector<bool> isTouched(nrOfPositions);
+
+			//vertex every vertex of the collapsed position moves onto
+			std::vector<std::pair<uint32_t, uint32_t>> partners{};
+
+			const auto trianglesAround = [&](uint32_t vertex)
+			{
+				return std::span<const uint32_t>{ vertexTriangles.data() + triangleOffsets[vertex], triangleOffsets[vertex + 1] - triangleOffsets[vertex] };
+			};
+
+			//a vertex moves onto the vertex of the other position it shares an edge with, so seams collapse along themselves
+			//without one the seam tears, the vertex then takes the one with the closest normal
+			const auto findPartner = [&](uint32_t vertex, uint32_t to, bool& isSeamKept)
+			{
+				for (const uint32_t triangle : trianglesAround(vertex))
+				{
+					for (uint32_t corner{}; corner < 3; ++corner)
+					{
+						if (vertexPositions[result[triangle * 3 + corner]] == to) return result[triangle * 3 + corner];
+					}
+				}
+
+				isSeamKept = false;
+
+				uint32_t partner{ noVertex };
+				float bestDot{ -FLT_MAX };
+
+				for (const uint32_t candidate : positionVertices[to])
+				{
+					if (trianglesAround(candidate).empty()) continue;
+
+					const float dot{ Vector3::Dot(vertices[vertex].normal, vertices[candidate].normal) };
+
+					if (dot > bestDot)
+					{
+						bestDot = dot;
+						partner = candidate;
+					}
+				}
+
+				return partner;
+			};
+
+			const auto findPartners = [&](uint32_t from, uint32_t to)
+			{
+				partners.clear();
+
+				bool isSeamKept{ true };
+
+				for (const uint32_t vertex : positionVertices[from])
+				{
+					if (!trianglesAround(vertex).empty()) partners.emplace_back(vertex, findPartner(vertex, to, isSeamKept));
+				}
+
+				return isSeamKept;
+			};
+
+			//collapse in passes, every position changes at most once per pass so the checks see the real neighbourhood
+			while (result.size() > targetIndexCount)
+			{
+				//triangles around every vertex
+				std::fill(triangleOffsets.begin(), triangleOffsets.end(), 0);
+
+				for (const uint32_t vertex : result)
+				{
+					++triangleOffsets[vertex + 1];
+				}
+
+				std::partial_sum(triangleOffsets.begin(), triangleOffsets.end(), triangleOffsets.begin());
+
+				vertexTriangles.resize(result.size());
+				fillOffsets.assign(triangleOffsets.begin(), triangleOffsets.end() - 1);
+
+				for (size_t idx{}; idx < result.size(); ++idx)
+				{
+					vertexTriangles[fillOffsets[result[idx]]++] = static_cast<uint32_t>(idx / 3);
+				}
+
+				collapses.clear();
+
+				for (size_t idx{}; idx < result.size(); idx += 3)
+				{
+					for (uint32_t corner{}; corner < 3; ++corner)
+					{
+						const uint32_t a{ vertexPositions[result[idx + corner]] };
+						const uint32_t b{ vertexPositions[result[idx + (corner + 1) % 3]] };
+
+						const uint64_t key{ edgeKey(result[idx + corner], result[idx + (corner + 1) % 3]) };
+						const bool isBorder{ edgeUses[key] == 1 };
+
+						//every inner edge is seen from both of its triangles, only add it once
+						if (a > b && !isBorder) continue;
+
+						Quadric quadric{ quadrics[a] };
+						quadric += quadrics[b];
+
+						//tearing a seam costs as much as moving the surface by the length of the edge
+						const double seamError{ (position(positionVertices[a][0]) - position(positionVertices[b][0])).SqrMagnitude() };
+
+						const auto collapseError = [&](uint32_t from, uint32_t to)
+						{
+							if (!canCollapse(from, isBorder)) return std::numeric_limits<double>::max();
+
+							const double error{ quadric.Error(position(positionVertices[to][0])) };
+
+							return findPartners(from, to) ? error : error + seamError;
+						};
+
+						const double errorAB{ collapseError(a, b) };
+						const double errorBA{ collapseError(b, a) };
+
+						if (std::min(errorAB, errorBA) == std::numeric_limits<double>::max()) continue;
+
+						collapses.push_back(errorAB <= errorBA ? Collapse{ a, b, errorAB } : Collapse{ b, a, errorBA });
+					}
+				}
+
+				if (collapses.empty()) break;
+
+				std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.error < b.error; });
+
+				std::fill(isTouched.begin(), isTouched.end(), false);
+
+				//only the cheapest part of the collapses per pass, the ones after it are cheaper once their neighbours moved
+				const size_t trianglesToRemove{ std::min((result.size() - targetIndexCount) / 3, std::max<size_t>(result.size() / 3 / 8, 1)) };
+				size_t removedTriangles{};
+
+				for (const Collapse& collapse : collapses)
+				{
+					if (collapse.error > maxSquaredError || removedTriangles >= trianglesToRemove) break;
+
+					if (isTouched[collapse.from] || isTouched[collapse.to]) continue;
+
+					findPartners(collapse.from, collapse.to);
+
+					//the triangles that stay may not flip when the position moves
+					const Vector3& target{ position(positionVertices[collapse.to][0]) };
+
+					bool isFlipping{ false };
+					uint32_t nrOfRemoved{};
+
+					for (const auto& [vertex, partner] : partners)
+					{
+						for (const uint32_t triangle : trianglesAround(vertex))
+						{
+							const uint32_t* pTriangle{ result.data() + triangle * 3 };
+
+							if (vertexPositions[pTriangle[0]] == collapse.to || vertexPositions[pTriangle[1]] == collapse.to || vertexPositions[pTriangle[2]] == collapse.to)
+							{
+								++nrOfRemoved;
+								continue;
+							}
+
+							const auto moved = [&](uint32_t corner) -> const Vector3& { return pTriangle[corner] == vertex ? target : position(pTriangle[corner]); };
+
+							const Vector3 before{ Vector3::Cross(position(pTriangle[1]) - position(pTriangle[0]), position(pTriangle[2]) - position(pTriangle[0])) };
+							const Vector3 after{ Vector3::Cross(moved(1) - moved(0), moved(2) - moved(0)) };
+
+							if (Vector3::Dot(before, after) <= 0.f)
+							{
+								isFlipping = true;
+								break;
+							}
+						}
+
+						if (isFlipping) break;
+					}
+
+					if (isFlipping) continue;
+
+					for (const auto& [vertex, partner] : partners)
+					{
+						remap[vertex] = partner;
+
+						for (const uint32_t triangle : trianglesAround(vertex))
+						{
+							for (uint32_t corner{}; corner < 3; ++corner)
+							{
+								isTouched[vertexPositions[result[triangle * 3 + corner]]] = true;
+							}
+						}
+					}
+
+					quadrics[collapse.to] += quadrics[collapse.from];
+
+					resultError = std::max(resultError, static_cast<float>(std::sqrt(collapse.error)));
+					removedTriangles += nrOfRemoved;
+				}
+
+				if (removedTriangles == 0) break;
+
+				//move the collapsed corners and drop the triangles that lost an edge
+				size_t writeIndex{};
+
+				for (size_t idx{}; idx < result.size(); idx += 3)
+				{
+					uint32_t corners[3]{};
+
+					for (uint32_t corner{}; corner < 3; ++corner)
+					{
+						const uint32_t vertex{ result[idx + corner] };
+						corners[corner] = isTouched[vertexPositions[vertex]] ? remap[vertex] : vertex;
+					}
+
+					const uint32_t p0{ vertexPositions[corners[0]] };
+					const uint32_t p1{ vertexPositions[corners[1]] };
+					const uint32_t p2{ vertexPositions[corners[2]] };
+
+					if (p0 == p1 || p1 == p2 || p0 == p2) continue;
+
+					std::copy(std::begin(corners), std::end(corners), result.begin() + writeIndex);
+					writeIndex += 3;
+				}
+
+				result.resize(writeIndex);
+
+				classifyEdges();
+			}
+
+			return result;
+		}
+
+		std::vector<MeshLod> BuildLods(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, uint32_t maxLods, uint32_t cacheSize)
+		{
+			std::vector<MeshLod> lods{ MeshLod{ 0, static_cast<uint32_t>(indices.size()), 0, static_cast<uint32_t>(vertices.size()), 0.f } };
+
+			if (indices.empty()) return lods;
+
+			//the allowed error is relative to the size of the mesh, the coarsest lods are only picked when they cover a few pixels
+			Vector3 minPosition{ vertices[0].position };
+			Vector3 maxPosition{ vertices[0].position };
+
+			for (const Vertex& vertex : vertices)
+			{
+				minPosition = Vector3{ std::min(minPosition.x, vertex.position.x), std::min(minPosition.y, vertex.position.y), std::min(minPosition.z, vertex.position.z) };
+				maxPosition = Vector3{ std::max(maxPosition.x, vertex.position.x), std::max(maxPosition.y, vertex.position.y), std::max(maxPosition.z, vertex.position.z) };
+			}
+
+			const float maxError{ (maxPosition - minPosition).Magnitude() * 0.05f };
+
+			const std::vector<uint32_t> fullDetail{ indices };
+			std::vector<uint32_t> clusters{};
+
+			for (uint32_t lod{ 1 }; lod < maxLods; ++lod)
+			{
+				//every lod is simplified from the full detail mesh so the quadrics measure the distance to the real surface
+				const size_t targetIndexCount{ (fullDetail.size() >> lod) / 3 * 3 };
+
+				float error{};
+				std::vector<uint32_t> simplified{ Simplify(vertices, fullDetail, targetIndexCount, maxError, error) };
+
+				//stop when the simplifier is stuck on locked vertices or the error limit
+				if (simplified.empty() || simplified.size() > lods.back().indexCount * 3 / 4) break;
+
+				OptimizeVertexCache(simplified, vertices.size(), clusters, cacheSize);
+
+				//copy the used vertices behind the previous lods in the order they are first used
+				MeshLod& newLod{ lods.emplace_back(MeshLod{ static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(simplified.size()), static_cast<uint32_t>(vertices.size()), 0, std::max(error, lods.back().error) }) };
+
+				std::unordered_map<uint32_t, uint32_t> lodVertices{};
+
+				for (const uint32_t vertex : simplified)
+				{
+					const auto [it, isNew] { lodVertices.try_emplace(vertex, static_cast<uint32_t>(vertices.size())) };
+
+					if (isNew) vertices.push_back(vertices[vertex]);
+
+					indices.push_back(it->second);
+				}
+
+				newLod.vertexCount = static_cast<uint32_t>(vertices.size()) - newLod.vertexOffset;
+			}
+
+			return lods;
+		}
+
+		float CalculateACMR(const std::vector<uint32_t>& indices, size_t nrOfVertices, uint32_t cacheSize)
+		{
+			if (indices.size() < 3) return 0.f;
+
+			CacheSimulation cache{ nrOfVertices, cacheSize };
+
+			uint32_t misses{};
+
+			for (const uint32_t index : indices)
+			{
+				misses += cache.Access(index);
+			}
+
+			return static_cast<float>(misses) / static_cast<float>(indices.size() / 3);
+		}
+	}
+}
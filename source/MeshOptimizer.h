@@ -0,0 +1,61 @@
+#pragma once
+#include <span>
+#include <vector>
+#include "DataTypes.h"
+
+namespace dae
+{
+	//load time passes over the index buffer, run after parsing and before the mesh is created
+	namespace MeshOptimizer
+	{
+		//fifo size used for the triangle ordering and the reported ACMR
+		constexpr uint32_t DefaultCacheSize{ 16 };
+
+		struct Statistics
+		{
+			size_t nrOfParsedVertices{};
+			size_t nrOfVertices{};
+
+			//average cache miss ratio, vertices transformed per triangle
+			float fileOrderACMR{};
+			float optimizedACMR{};
+
+			//vertices on meshlet borders are duplicated so every meshlet owns a vertex range
+			size_t nrOfMeshlets{};
+			size_t nrOfMeshletVertices{};
+		};
+
+		//welds, reorders for the vertex cache and then for overdraw
+		Statistics Optimize(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, uint32_t cacheSize = DefaultCacheSize);
+
+		//merges vertices with the same position, normal and uv, the tangents of merged vertices are averaged
+		//without this every triangle corner is its own vertex and the order of the triangles does not matter for the cache
+		void WeldVertices(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+		//reorders the triangles for the post transform vertex cache (tipsify)
+		//clusters receives the first triangle of every run that starts with a cold cache, the overdraw pass only moves whole clusters
+		void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t nrOfVertices, std::vector<uint32_t>& clusters, uint32_t cacheSize = DefaultCacheSize);
+
+		//splits the clusters as long as their ACMR stays within threshold of the cache optimized order
+		//and sorts them so the ones facing away from the center come first, they tend to occlude the rest from any direction
+		void OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& clusters, float threshold = 1.05f, uint32_t cacheSize = DefaultCacheSize);
+
+		//cuts the triangles into meshlets in index order and computes their bounding sphere and normal cone
+		//the vertices are duplicated per meshlet and the indices rewritten, the triangle order is kept
+		std::vector<Meshlet> BuildMeshlets(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, uint32_t maxVertices = 64, uint32_t maxTriangles = 124);
+
+		//quadric error edge collapse down to targetIndexCount indices, stops early when a collapse would move the surface more than maxError
+		//border vertices only slide along the border, corners of the border are locked
+		//seam vertices (same position, other normal or uv) move onto the vertex of the other position they share an edge with
+		//a collapse that would tear the seam still happens but costs an extra squared edge length, the torn vertex takes the one with the closest normal
+		//the result indexes the same vertices
+		std::vector<uint32_t> Simplify(const std::vector<Vertex>& vertices, std::span<const uint32_t> indices, size_t targetIndexCount, float maxError, float& resultError);
+
+		//appends up to maxLods - 1 simplified copies of the mesh, each with half the triangles of the one before
+		//every lod gets its own vertex range so the software rasterizer only transforms what it draws, the first lod is the mesh as it was
+		std::vector<MeshLod> BuildLods(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, uint32_t maxLods = 4, uint32_t cacheSize = DefaultCacheSize);
+
+		//simulates a fifo cache of cacheSize vertices
+		float CalculateACMR(const std::vector<uint32_t>& indices, size_t nrOfVertices, uint32_t cacheSize = DefaultCacheSize);
+	}
+}
@@ -0,0 +1,181 @@
+#include "pch.h"
+#include "NormalMapBaker.h"
+#include "Texture.h"
+
+namespace dae
+{
+	namespace NormalMapBaker
+	{
+		Texture* BakeObjectSpace(const Texture& tangentSpaceMap, std::span<const Vertex> vertices, std::span<const uint32_t> indices, std::vector<uint8_t>& objectSpaceTriangles)
+		{
+			const int width{ tangentSpaceMap.GetWidth() };
+			const int height{ tangentSpaceMap.GetHeight() };
+
+			SDL_Surface* pSurface{ SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_ABGR8888) };
+
+			if (pSurface == nullptr) return nullptr;
+
+			uint32_t* pPixels{ static_cast<uint32_t*>(pSurface->pixels) };
+			const int pitch{ pSurface->pitch / 4 };
+
+			//texels not covered by any triangle or the gutter point along +z, they are never sampled
+			std::fill_n(pPixels, static_cast<size_t>(pitch) * height, 0xFFFF8080);
+
+			//triangle that owns the inside of each texel, used to find triangles sharing uv space
+			constexpr uint32_t noOwner{ UINT32_MAX };
+			std::vector<uint32_t> texelOwners(static_cast<size_t>(width) * height, noOwner);
+
+			//texels written by a triangle, the gutter grows from them
+			std::vector<uint8_t> coveredTexels(static_cast<size_t>(width) * height, 0);
+
+			//only set for the triangles that are baked
+			const size_t nrOfTriangles{ indices.size() / 3 };
+			objectSpaceTriangles.assign(nrOfTriangles, 0);
+
+			const auto encodeNormal = [](const Vector3& normal)
+			{
+				//[-1, 1] into [0, 255]
+				const uint32_t r{ static_cast<uint32_t>(Saturate(normal.x * 0.5f + 0.5f) * 255.f + 0.5f) };
+				const uint32_t g{ static_cast<uint32_t>(Saturate(normal.y * 0.5f + 0.5f) * 255.f + 0.5f) };
+				const uint32_t b{ static_cast<uint32_t>(Saturate(normal.z * 0.5f + 0.5f) * 255.f + 0.5f) };
+
+				return r | (g << 8) | (b << 16) | 0xFF000000;
+			};
+
+			//texel centers on a shared edge belong to both triangles, only the inside counts as a conflict
+			constexpr float edgeMargin{ 0.01f };
+
+			for (size_t triangle{ 0 }; triangle < nrOfTriangles; ++triangle)
+			{
+				const Vertex& v0{ vertices[indices[triangle * 3]] };
+				const Vertex& v1{ vertices[indices[triangle * 3 + 1]] };
+				const Vertex& v2{ vertices[indices[triangle * 3 + 2]] };
+
+				//uvs in texel space
+				const Vector2 size{ static_cast<float>(width), static_cast<float>(height) };
+				const Vector2 uv0{ v0.uv.x * size.x, v0.uv.y * size.y };
+				const Vector2 uv1{ v1.uv.x * size.x, v1.uv.y * size.y };
+				const Vector2 uv2{ v2.uv.x * size.x, v2.uv.y * size.y };
+
+				const float area{ Vector2::Cross(uv1 - uv0, uv2 - uv0) };
+
+				if (AreEqual(area, 0.f)) continue;
+
+				const float invArea{ 1.f / area };
+
+				const Vector2 minUV{ Vector2::Min(uv0, Vector2::Min(uv1, uv2)) };
+				const Vector2 maxUV{ Vector2::Max(uv0, Vector2::Max(uv1, uv2)) };
+
+				//a wrapping triangle samples texels that are only baked for the part inside the map
+				if (minUV.x < 0.f || minUV.y < 0.f || maxUV.x > size.x || maxUV.y > size.y) continue;
+
+				//cleared again when it shares texels or covers none
+				objectSpaceTriangles[triangle] = 1;
+				bool isBaked{};
+
+				const int minX{ std::clamp(static_cast<int>(minUV.x), 0, width - 1) };
+				const int minY{ std::clamp(static_cast<int>(minUV.y), 0, height - 1) };
+				const int maxX{ std::clamp(static_cast<int>(maxUV.x), 0, width - 1) };
+				const int maxY{ std::clamp(static_cast<int>(maxUV.y), 0, height - 1) };
+
+				for (int y{ minY }; y <= maxY; ++y)
+				{
+					for (int x{ minX }; x <= maxX; ++x)
+					{
+						const Vector2 point{ static_cast<float>(x) + 0.5f, static_cast<float>(y) + 0.5f };
+
+						//barycentric weights, the sign of the area cancels out
+						const float w0{ Vector2::Cross(uv2 - uv1, point - uv1) * invArea };
+						const float w1{ Vector2::Cross(uv0 - uv2, point - uv2) * invArea };
+						const float w2{ 1.f - w0 - w1 };
+
+						if (w0 < 0.f || w1 < 0.f || w2 < 0.f) continue;
+
+						const size_t texelIdx{ static_cast<size_t>(x) + static_cast<size_t>(y) * width };
+
+						if (w0 > edgeMargin && w1 > edgeMargin && w2 > edgeMargin)
+						{
+							//another triangle already uses this texel, neither can be baked
+							if (texelOwners[texelIdx] != noOwner && texelOwners[texelIdx] != triangle)
+							{
+								objectSpaceTriangles[texelOwners[texelIdx]] = 0;
+								objectSpaceTriangles[triangle] = 0;
+							}
+
+							texelOwners[texelIdx] = static_cast<uint32_t>(triangle);
+						}
+
+						//tangent frame at the texel, same construction as the per pixel shading
+						const Vector3 normal{ (v0.normal * w0 + v1.normal * w1 + v2.normal * w2).Normalized() };
+						const Vector3 tangent{ (v0.tangent * w0 + v1.tangent * w1 + v2.tangent * w2).Normalized() };
+						const Vector3 binormal{ Vector3::Cross(normal, tangent).Normalized() };
+
+						const Vector2 texelUV{ point.x / size.x, point.y / size.y };
+
+						Vector3 sampledNormal{ tangentSpaceMap.SampleVector3(texelUV) };
+						sampledNormal = 2 * sampledNormal - Vector3::Identity;
+
+						Vector3 objectNormal{ tangent * sampledNormal.x + binormal * sampledNormal.y + normal * sampledNormal.z };
+						objectNormal.Normalize();
+
+						pPixels[x + y * pitch] = encodeNormal(objectNormal);
+						coveredTexels[texelIdx] = 1;
+						isBaked = true;
+					}
+				}
+
+				//a triangle between the texel centers would only sample its neighbours
+				if (!isBaked) objectSpaceTriangles[triangle] = 0;
+			}
+
+			//the filtering and the pixels at the edge of a chart read texels outside it, the gutter gives them the normals of the chart
+			//every pass grows the baked texels by one, an empty texel takes the average of its baked neighbours
+			constexpr int gutterSize{ 4 };
+			std::vector<std::pair<size_t, uint32_t>> gutterTexels{};
+
+			for (int pass{ 0 }; pass < gutterSize; ++pass)
+			{
+				gutterTexels.clear();
+
+				for (int y{ 0 }; y < height; ++y)
+				{
+					for (int x{ 0 }; x < width; ++x)
+					{
+						if (coveredTexels[static_cast<size_t>(x) + static_cast<size_t>(y) * width]) continue;
+
+						Vector3 sum{};
+						int nrOfNeighbours{};
+
+						for (int ny{ std::max(y - 1, 0) }; ny <= std::min(y + 1, height - 1); ++ny)
+						{
+							for (int nx{ std::max(x - 1, 0) }; nx <= std::min(x + 1, width - 1); ++nx)
+							{
+								if (!coveredTexels[static_cast<size_t>(nx) + static_cast<size_t>(ny) * width]) continue;
+
+								const uint32_t pixel{ pPixels[nx + ny * pitch] };
+								sum += Vector3{ static_cast<float>(pixel & 0xFF), static_cast<float>((pixel >> 8) & 0xFF), static_cast<float>((pixel >> 16) & 0xFF) } / 127.5f - Vector3::Identity;
+								++nrOfNeighbours;
+							}
+						}
+
+						//opposite normals cancel out, the texel is left to the next pass
+						if (nrOfNeighbours == 0 || AreEqual(sum.SqrMagnitude(), 0.f)) continue;
+
+						gutterTexels.emplace_back(static_cast<size_t>(x) + static_cast<size_t>(y) * width, encodeNormal(sum.Normalized()));
+					}
+				}
+
+				if (gutterTexels.empty()) break;
+
+				//written after the pass, so a pass only reads the texels of the ones before
+				for (const auto& [texelIdx, pixel] : gutterTexels)
+				{
+					pPixels[texelIdx % width + texelIdx / width * pitch] = pixel;
+					coveredTexels[texelIdx] = 1;
+				}
+			}
+
+			return Texture::LoadFromSurface(pSurface, nullptr);
+		}
+	}
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include <span>
+#include <vector>
+#include "DataTypes.h"
+
+namespace dae
+{
+	class Texture;
+
+	namespace NormalMapBaker
+	{
+		//converts a tangent space normal map to object space using the tangent frames of the mesh
+		//triangles that share texels with another triangle (mirrored or overlapping uvs), reach outside [0, 1] or cover no texel cannot be baked,
+		//objectSpaceTriangles holds 1 for every triangle that can use the baked map and 0 for the others
+		//the baked texels are dilated a few texels past the edges of the charts
+		//returns a software only texture
+		Texture* BakeObjectSpace(const Texture& tangentSpaceMap, std::span<const Vertex> vertices, std::span<const uint32_t> indices, std::vector<uint8_t>& objectSpaceTriangles);
+	}
+}
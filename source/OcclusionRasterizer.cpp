@@ -0,0 +1,184 @@
+#include "pch.h"
+#include "OcclusionRasterizer.h"
+
+namespace dae
+{
+	void OcclusionRasterizer::Clear()
+	{
+		std::fill(m_Depth.begin(), m_Depth.end(), FLT_MAX);
+		m_NrOfTriangles = 0;
+	}
+
+	void OcclusionRasterizer::RenderTriangles(const Vector4Streams& positions, std::span<const uint32_t> indices, uint32_t firstVertex)
+	{
+		const auto isInFront = [&](uint32_t idx) { return positions.w[idx] > 0.f && positions.z[idx] >= 0.f; };
+
+		//ndc to the pixels of the occlusion buffer
+		const auto toScreenX = [](float x) { return (x + 1) / 2 * static_cast<float>(m_Width); };
+		const auto toScreenY = [](float y) { return (1 - y) / 2 * static_cast<float>(m_Height); };
+
+		for (size_t index{}; index + 2 < indices.size(); index += 3)
+		{
+			const uint32_t idx0{ indices[index] - firstVertex };
+			const uint32_t idx1{ indices[index + 1] - firstVertex };
+			const uint32_t idx2{ indices[index + 2] - firstVertex };
+
+			//without clipping, a triangle through the near plane is not drawn at all
+			if (!isInFront(idx0) || !isInFront(idx1) || !isInFront(idx2)) continue;
+
+			RenderTriangle(
+				toScreenX(positions.x[idx0]), toScreenY(positions.y[idx0]), positions.z[idx0],
+				toScreenX(positions.x[idx1]), toScreenY(positions.y[idx1]), positions.z[idx1],
+				toScreenX(positions.x[idx2]), toScreenY(positions.y[idx2]), positions.z[idx2]);
+		}
+	}
+
+	void OcclusionRasterizer::RenderTriangle(float x0, float y0, float z0, float x1, float y1, float z1, float x2, float y2, float z2)
+	{
+		float area{ (x1 - x0) * (y2 - y0) - (y1 - y0) * (x2 - x0) };
+
+		//same setup as RenderTriangle, the winding is flipped instead of culled so the edges are positive inside
+		if (area < 0.f)
+		{
+			std::swap(x1, x2);
+			std::swap(y1, y2);
+			std::swap(z1, z2);
+			area = -area;
+		}
+
+		if (area < FLT_EPSILON) return;
+
+		const int minX{ std::max(static_cast<int>(std::min({ x0, x1, x2 })), 0) & ~3 };
+		const int minY{ std::max(static_cast<int>(std::min({ y0, y1, y2 })), 0) };
+		const int maxX{ std::min(static_cast<int>(std::max({ x0, x1, x2 })), m_Width - 1) };
+		const int maxY{ std::min(static_cast<int>(std::max({ y0, y1, y2 })), m_Height - 1) };
+
+		if (minX > maxX || minY > maxY) return;
+
+		++m_NrOfTriangles;
+
+		//edge functions a * x + b * y + c, the one of an edge is the weight of the opposite vertex times the area
+		const float a12{ y1 - y2 }, b12{ x2 - x1 }, c12{ -(a12 * x1 + b12 * y1) };
+		const float a20{ y2 - y0 }, b20{ x0 - x2 }, c20{ -(a20 * x2 + b20 * y2) };
+		const float a01{ y0 - y1 }, b01{ x1 - x0 }, c01{ -(a01 * x0 + b01 * y0) };
+
+		//ndc depth is linear in screen space, no perspective correction needed
+		const float invArea{ 1.f / area };
+		const float depthA{ (a12 * z0 + a20 * z1 + a01 * z2) * invArea };
+		const float depthB{ (b12 * z0 + b20 * z1 + b01 * z2) * invArea };
+		const float depthC{ (c12 * z0 + c20 * z1 + c01 * z2) * invArea };
+
+		//sampled at the pixel centers
+		const __m128 laneOffsets{ _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f) };
+		const __m128 zero{ _mm_setzero_ps() };
+
+		for (int py{ minY }; py <= maxY; ++py)
+		{
+			const float centerY{ static_cast<float>(py) + 0.5f };
+
+			const __m128 row12{ _mm_set1_ps(b12 * centerY + c12) };
+			const __m128 row20{ _mm_set1_ps(b20 * centerY + c20) };
+			const __m128 row01{ _mm_set1_ps(b01 * centerY + c01) };
+			const __m128 rowDepth{ _mm_set1_ps(depthB * centerY + depthC) };
+
+			float* pDepthRow{ m_Depth.data() + static_cast<size_t>(py) * m_Width };
+
+			//the width is a multiple of 4 and minX is aligned, a group never reads past the row
+			for (int px{ minX }; px <= maxX; px += 4)
+			{
+				const __m128 centerX{ _mm_add_ps(_mm_set1_ps(static_cast<float>(px)), laneOffsets) };
+
+				const __m128 edge12{ _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a12), centerX), row12) };
+				const __m128 edge20{ _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a20), centerX), row20) };
+				const __m128 edge01{ _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a01), centerX), row01) };
+
+				const __m128 isInside{ _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(edge12, zero), _mm_cmpge_ps(edge20, zero)), _mm_cmpge_ps(edge01, zero)) };
+
+				if (_mm_movemask_ps(isInside) == 0) continue;
+
+				const __m128 depth{ _mm_add_ps(_mm_mul_ps(_mm_set1_ps(depthA), centerX), rowDepth) };
+				const __m128 stored{ _mm_loadu_ps(pDepthRow + px) };
+
+				//keep the nearest depth on the covered lanes, leave the others
+				const __m128 nearest{ _mm_min_ps(stored, depth) };
+				_mm_storeu_ps(pDepthRow + px, _mm_or_ps(_mm_and_ps(isInside, nearest), _mm_andnot_ps(isInside, stored)));
+			}
+		}
+	}
+
+	bool OcclusionRasterizer::IsBoxOccluded(const Vector3& min, const Vector3& max, const Matrix& viewProjection) const
+	{
+		ScreenBounds bounds{};
+
+		if (!ProjectBox(min, max, viewProjection, static_cast<float>(m_Width), static_cast<float>(m_Height), bounds)) return false;
+
+		//the depth of a pixel only holds at its center, the rectangle is grown by a pixel so the edges of the occluders never hide anything
+		const int minX{ std::max(static_cast<int>(std::floor(bounds.minX)) - 1, 0) };
+		const int minY{ std::max(static_cast<int>(std::floor(bounds.minY)) - 1, 0) };
+		const int maxX{ std::min(static_cast<int>(bounds.maxX) + 1, m_Width - 1) };
+		const int maxY{ std::min(static_cast<int>(bounds.maxY) + 1, m_Height - 1) };
+
+		//off screen, nothing is known about it
+		if (minX > maxX || minY > maxY) return false;
+
+		const __m128 laneOffsets{ _mm_setr_ps(0.f, 1.f, 2.f, 3.f) };
+		const __m128 firstX{ _mm_set1_ps(static_cast<float>(minX)) };
+		const __m128 lastX{ _mm_set1_ps(static_cast<float>(maxX)) };
+		const __m128 nearestDepth{ _mm_set1_ps(bounds.nearestDepth) };
+
+		for (int py{ minY }; py <= maxY; ++py)
+		{
+			const float* pDepthRow{ m_Depth.data() + static_cast<size_t>(py) * m_Width };
+
+			for (int px{ minX & ~3 }; px <= maxX; px += 4)
+			{
+				const __m128 x{ _mm_add_ps(_mm_set1_ps(static_cast<float>(px)), laneOffsets) };
+				const __m128 isCovered{ _mm_and_ps(_mm_cmpge_ps(x, firstX), _mm_cmple_ps(x, lastX)) };
+
+				//a pixel whose occluder is not in front of the box lets it through
+				const __m128 isVisible{ _mm_and_ps(isCovered, _mm_cmpge_ps(_mm_loadu_ps(pDepthRow + px), nearestDepth)) };
+
+				if (_mm_movemask_ps(isVisible) != 0) return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool OcclusionRasterizer::ProjectBox(const Vector3& min, const Vector3& max, const Matrix& viewProjection, float width, float height, ScreenBounds& bounds)
+	{
+		bounds = { FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX, FLT_MAX };
+
+		for (int corner{}; corner < 8; ++corner)
+		{
+			const Vector4 projected
+			{
+				viewProjection.TransformPoint(Vector4
+				{
+					corner & 1 ? max.x : min.x,
+					corner & 2 ? max.y : min.y,
+					corner & 4 ? max.z : min.z,
+					1.f
+				})
+			};
+
+			//the box reaches up to the camera
+			if (projected.w <= 0.f || projected.z < 0.f) return false;
+
+			const float invW{ 1.f / projected.w };
+
+			const float screenX{ (projected.x * invW + 1) / 2 * width };
+			const float screenY{ (1 - projected.y * invW) / 2 * height };
+
+			bounds.minX = std::min(bounds.minX, screenX);
+			bounds.minY = std::min(bounds.minY, screenY);
+			bounds.maxX = std::max(bounds.maxX, screenX);
+			bounds.maxY = std::max(bounds.maxY, screenY);
+
+			//depth only grows with the distance, the nearest point of the box is one of its corners
+			bounds.nearestDepth = std::min(bounds.nearestDepth, projected.z * invW);
+		}
+
+		return true;
+	}
+}
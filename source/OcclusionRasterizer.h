@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "Matrix.h"
+
+namespace dae
+{
+	//screen rectangle and nearest depth (ndc) of a projected box
+	struct ScreenBounds
+	{
+		float minX{};
+		float minY{};
+		float maxX{};
+		float maxY{};
+		float nearestDepth{};
+	};
+
+	//depth only rasterizer at a fixed low resolution, no shading, no varyings, 4 pixels at a time
+	//the large occluders of a frame are drawn first, then the other objects test their projected boxes against it before any of their vertices are transformed
+	class OcclusionRasterizer final
+	{
+	public:
+
+		static constexpr int m_Width{ 256 };
+		static constexpr int m_Height{ 128 };
+
+		OcclusionRasterizer() : m_Depth(static_cast<size_t>(m_Width) * m_Height, FLT_MAX) {}
+
+		void Clear();
+
+		//positions holds ndc x, y, z and clip w of the vertices (Matrix::TransformAndProject), index - firstVertex is the position of an index
+		//triangles reaching in front of the near plane are skipped, both windings are drawn
+		void RenderTriangles(const Vector4Streams& positions, std::span<const uint32_t> indices, uint32_t firstVertex);
+
+		//true when the box, in the space the matrix projects from, is behind the occluders at every pixel it covers
+		bool IsBoxOccluded(const Vector3& min, const Vector3& max, const Matrix& viewProjection) const;
+
+		uint32_t GetNrOfTriangles() const { return m_NrOfTriangles; }
+
+		//projects the corners of a box onto a width x height screen, false when a corner is in front of the near plane
+		static bool ProjectBox(const Vector3& min, const Vector3& max, const Matrix& viewProjection, float width, float height, ScreenBounds& bounds);
+
+	private:
+
+		//ndc z, FLT_MAX where nothing was drawn
+		std::vector<float> m_Depth{};
+
+		uint32_t m_NrOfTriangles{};
+
+		void RenderTriangle(float x0, float y0, float z0, float x1, float y1, float z1, float x2, float y2, float z2);
+	};
+}
@@ -0,0 +1,130 @@
+#pragma once
+#include <cstdint>
+#include <emmintrin.h>
+#include "ColorRGB.h"
+
+namespace dae
+{
+	//packs float colors straight into the pixels of a 32 bit surface
+	//the channel layout is read from the format once, SDL_MapRGB looked it up for every pixel
+	class PixelPacker final
+	{
+	public:
+
+		PixelPacker() = default;
+
+		explicit PixelPacker(const SDL_PixelFormat* pFormat) :
+			m_RedShift(pFormat->Rshift),
+			m_GreenShift(pFormat->Gshift),
+			m_BlueShift(pFormat->Bshift),
+			m_RedLoss(pFormat->Rloss),
+			m_GreenLoss(pFormat->Gloss),
+			m_BlueLoss(pFormat->Bloss),
+			m_AlphaMask(pFormat->Amask)
+		{
+		}
+
+		//SDL_MapRGB without the format lookup
+		uint32_t Pack(uint8_t r, uint8_t g, uint8_t b) const
+		{
+			return (uint32_t{ r } >> m_RedLoss) << m_RedShift | (uint32_t{ g } >> m_GreenLoss) << m_GreenShift | (uint32_t{ b } >> m_BlueLoss) << m_BlueShift | m_AlphaMask;
+		}
+
+		//colors brighter than 1 are scaled down by their largest channel (ColorRGB::MaxToOne) instead of clamped, so the hue stays
+		uint32_t Pack(ColorRGB color) const
+		{
+			color.MaxToOne();
+
+			return Pack(static_cast<uint8_t>(color.r * 255), static_cast<uint8_t>(color.g * 255), static_cast<uint8_t>(color.b * 255));
+		}
+
+		//4 colors as structure of arrays, same result as the scalar Pack
+		__m128i Pack4(__m128 r, __m128 g, __m128 b) const
+		{
+			//divide like MaxToOne does, a multiply by the reciprocal would round differently
+			const __m128 scale{ _mm_max_ps(_mm_max_ps(r, g), _mm_max_ps(b, _mm_set1_ps(1.f))) };
+			const __m128 toByte{ _mm_set1_ps(255.f) };
+			const __m128 zero{ _mm_setzero_ps() };
+
+			const __m128i red{ _mm_cvttps_epi32(_mm_max_ps(_mm_mul_ps(_mm_div_ps(r, scale), toByte), zero)) };
+			const __m128i green{ _mm_cvttps_epi32(_mm_max_ps(_mm_mul_ps(_mm_div_ps(g, scale), toByte), zero)) };
+			const __m128i blue{ _mm_cvttps_epi32(_mm_max_ps(_mm_mul_ps(_mm_div_ps(b, scale), toByte), zero)) };
+
+			const auto place = [](__m128i channel, int loss, int shift) { return _mm_sll_epi32(_mm_srl_epi32(channel, _mm_cvtsi32_si128(loss)), _mm_cvtsi32_si128(shift)); };
+
+			return _mm_or_si128(_mm_or_si128(place(red, m_RedLoss, m_RedShift), place(green, m_GreenLoss, m_GreenShift)),
+				_mm_or_si128(place(blue, m_BlueLoss, m_BlueShift), _mm_set1_epi32(static_cast<int>(m_AlphaMask))));
+		}
+
+	private:
+
+		int m_RedShift{ 16 };
+		int m_GreenShift{ 8 };
+		int m_BlueShift{ 0 };
+		int m_RedLoss{};
+		int m_GreenLoss{};
+		int m_BlueLoss{};
+		uint32_t m_AlphaMask{};
+	};
+
+	//collects the shaded pixels of a triangle and packs them 8 at a time
+	//the pixels are written when the batch is full and when it goes out of scope, so nothing may read them before that
+	class PixelBatch final
+	{
+	public:
+
+		PixelBatch(const PixelPacker& packer, uint32_t* pPixels) :
+			m_Packer(packer),
+			m_pPixels(pPixels)
+		{
+		}
+
+		~PixelBatch() { Flush(); }
+
+		PixelBatch(const PixelBatch&) = delete;
+		PixelBatch(PixelBatch&&) noexcept = delete;
+		PixelBatch& operator=(const PixelBatch&) = delete;
+		PixelBatch& operator=(PixelBatch&&) noexcept = delete;
+
+		void Add(int pixelIndex, const ColorRGB& color)
+		{
+			m_PixelIndices[m_Count] = pixelIndex;
+			m_Red[m_Count] = color.r;
+			m_Green[m_Count] = color.g;
+			m_Blue[m_Count] = color.b;
+
+			if (++m_Count == m_Size) Flush();
+		}
+
+		void Flush()
+		{
+			if (m_Count == 0) return;
+
+			//a partial batch packs the stale lanes too, only the filled ones are written
+			alignas(16) uint32_t packed[m_Size];
+
+			_mm_store_si128(reinterpret_cast<__m128i*>(packed), m_Packer.Pack4(_mm_load_ps(m_Red), _mm_load_ps(m_Green), _mm_load_ps(m_Blue)));
+			_mm_store_si128(reinterpret_cast<__m128i*>(packed + 4), m_Packer.Pack4(_mm_load_ps(m_Red + 4), _mm_load_ps(m_Green + 4), _mm_load_ps(m_Blue + 4)));
+
+			for (int idx{}; idx < m_Count; ++idx)
+			{
+				m_pPixels[m_PixelIndices[idx]] = packed[idx];
+			}
+
+			m_Count = 0;
+		}
+
+	private:
+
+		static constexpr int m_Size{ 8 };
+
+		const PixelPacker& m_Packer;
+		uint32_t* m_pPixels{};
+
+		alignas(16) float m_Red[m_Size]{};
+		alignas(16) float m_Green[m_Size]{};
+		alignas(16) float m_Blue[m_Size]{};
+		int m_PixelIndices[m_Size]{};
+		int m_Count{};
+	};
+}
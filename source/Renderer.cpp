@@ -2,7 +2,14 @@
 #include "Renderer.h"
 #include "Mesh.h"
 #include "Texture.h"
-#include "Utils.h"
+#include "ResourceManager.h"
+#include "TextureCache.h"
+#include "MeshCache.h"
+#include "Frustum.h"
+#include "NormalMapBaker.h"
+#include <array>
+#include <span>
+#include <utility>
 
 namespace dae {
 
@@ -26,10 +33,8 @@ namespace dae {
 			std::cout << "DirectX initialization failed!\n";
 		}
 
-		//create buffers
-		m_pFrontBuffer = SDL_GetWindowSurface(pWindow);
-		m_pBackBuffer = SDL_CreateRGBSurface(0, m_Width, m_Height, 32, 0, 0, 0, 0);
-		m_pBackBufferPixels = static_cast<uint32_t*>(m_pBackBuffer->pixels);
+		//create buffers, the back buffers belong to the presenter
+		m_pPresenter = std::make_unique<FramePresenter>(pWindow, m_Width, m_Height, 2, FramePresenter::PresentMode::Fifo);
 
 		m_NrOfPixels = m_Width * m_Height;
 
@@ -42,18 +47,58 @@ namespace dae {
 
 		m_pCamera->Initialize(m_AspectRatio, 45, Vector3{ 0, 0, -50 });
 
+		//one slot per thread for the vertex stage of the instances, twice so the next batch can be transformed while one is rasterized
+		m_TransformedInstances.resize(size_t{ JobSystem::GetNrOfThreads() } * 2);
+
+		//time of every job by stage, printed with the frame statistics
+		if (m_StageTimings.empty()) m_StageTimings = std::vector<ThreadStageTimings>(JobSystem::GetNrOfThreads());
+
+		JobSystem::SetTimingHook(&Renderer::AddStageTiming);
+
+
+		//time the resource loading to compare a cold and a warm texture cache
+		const uint64_t loadStart{ SDL_GetPerformanceCounter() };
 
 		InitializeMesh();
 
+		const float loadTime{ static_cast<float>(SDL_GetPerformanceCounter() - loadStart) * 1000.f / static_cast<float>(SDL_GetPerformanceFrequency()) };
+
 		std::cout << "\x1B[2J\x1B[H";//clear console
 
 		PrintInstructions();
 
+		std::cout << "\033[37m"; // TEXT COLOR
+		std::cout << "Resources loaded in " << loadTime << " ms ";
+		std::cout << (TextureCache::GetMisses() == 0 ? "(WARM" : "(COLD") << " texture cache, " << TextureCache::GetHits() << " hits / " << TextureCache::GetMisses() << " misses, ";
+		std::cout << (MeshCache::GetMisses() == 0 ? "WARM" : "COLD") << " mesh cache, " << MeshCache::GetHits() << " hits / " << MeshCache::GetMisses() << " misses)\n";
+
+		const size_t textureMemory{ m_pDiffuseTexture->GetMemorySize() + m_pNormalTexture->GetMemorySize() + m_pSpecularTexture->GetMemorySize() + m_pGlossTexture->GetMemorySize() };
+		std::cout << "Software texture memory: " << static_cast<float>(textureMemory) / (1024.f * 1024.f) << " MB " << (m_CompressSoftwareTextures ? "(BC1/BC5)" : "(RGBA8)") << "\n";
+		std::cout << "Vertices welded: " << m_MeshStatistics.nrOfParsedVertices << " -> " << m_MeshStatistics.nrOfVertices << ", ACMR (" << MeshOptimizer::DefaultCacheSize << " entry fifo): ";
+		std::cout << m_MeshStatistics.fileOrderACMR << " file order -> " << m_MeshStatistics.optimizedACMR << " optimized\n";
+		std::cout << "Meshlets: " << m_MeshStatistics.nrOfMeshlets << " (" << m_MeshStatistics.nrOfMeshletVertices << " vertices after splitting the borders)\n";
+		std::cout << "LODs:";
+		for (const MeshLod& lod : m_pMesh->GetLods())
+		{
+			std::cout << " " << lod.indexCount / 3 << " (" << lod.error << ")";
+		}
+		std::cout << " triangles (error)\n";
+		const size_t vertexCount{ m_pMesh->GetLods()[0].vertexCount };
+		std::cout << "Vertex data streamed per frame: " << static_cast<float>(vertexCount * sizeof(PackedVertex)) / 1024.f << " KB quantized (" << static_cast<float>(vertexCount * sizeof(Vertex)) / 1024.f << " KB unquantized)\n";
+		const size_t bakedTriangles{ static_cast<size_t>(std::count(m_ObjectSpaceTriangles.begin(), m_ObjectSpaceTriangles.end(), uint8_t{ 1 })) };
+		std::cout << "Object space normals: " << bakedTriangles << " / " << m_ObjectSpaceTriangles.size() << " triangles (shared or wrapping uvs stay tangent space)\n";
+		std::cout << "Resident texture memory: " << static_cast<float>(m_pResourceManager->GetResidentBytes()) / (1024.f * 1024.f) << " MB\n\n";
+
 		SDL_SetRelativeMouseMode(static_cast<SDL_bool>(m_IsCamLocked));
 	}
 
 	Renderer::~Renderer()
 	{
+		//shows the frames still in flight and stops the present thread
+		m_pPresenter.reset();
+
+		JobSystem::SetTimingHook(nullptr);
+
 		//release resources
 		if (m_pRenderTargetView) m_pRenderTargetView->Release();
 		if (m_pRenderTargetBuffer) m_pRenderTargetBuffer->Release();
@@ -68,13 +113,8 @@ namespace dae {
 		}
 		if (m_pDevice) m_pDevice->Release();
 
-		//delette buffer and textures
+		//delette buffer
 		delete[] m_pDepthBufferPixels;
-
-		delete m_pDiffuseTexture;
-		delete m_pNormalTexture;
-		delete m_pSpecularTexture;
-		delete m_pGlossTexture;
 	}
 
 	void Renderer::Update(const Timer* pTimer) const
@@ -82,16 +122,6 @@ namespace dae {
 		//update camera
 		m_pCamera->Update(pTimer);
 
-		//update mesh matrices
-		m_pMesh->SetProjectionMatrix(m_pCamera->viewMatrix * m_pCamera->projectionMatrix);
-		m_pMesh->SetWorldMatrix();
-		m_pMesh->SetInvViewMatrix(m_pCamera->invViewMatrix);
-
-		//update fire effect matrices
-		m_pFireMesh->SetProjectionMatrix(m_pCamera->viewMatrix * m_pCamera->projectionMatrix);
-		m_pFireMesh->SetWorldMatrix();
-		m_pFireMesh->SetInvViewMatrix(m_pCamera->invViewMatrix);
-
 		//if is able to rotate rotate matrices of both meshes
 		if(m_IsRotating)
 		{
@@ -99,6 +129,12 @@ namespace dae {
 			m_pFireMesh->SetRotationY(m_RotationSpeed * pTimer->GetElapsed());
 		}
 
+		//update mesh and fire effect matrices, only done when the mesh or the camera changed
+		m_pMesh->UpdateMatrices(m_pCamera->viewProjectionMatrix, m_pCamera->invViewMatrix, m_pCamera->version);
+		m_pFireMesh->UpdateMatrices(m_pCamera->viewProjectionMatrix, m_pCamera->invViewMatrix, m_pCamera->version);
+
+		//the software instances pick their own lod while they are culled
+		if (m_IsAutomaticLod) m_pMesh->SetLodIndex(m_pMesh->SelectLod(m_pMesh->GetWorldMatrix(), m_pMesh->GetLodIndex(), m_pCamera->origin, GetPixelsPerUnit(), m_LodPixelError, m_LodHysteresis));
 	}
 
 
@@ -112,6 +148,8 @@ namespace dae {
 
 		if(m_CurrentRasterizerState == RasterizerState::hardware)
 		{
+			//the swap chain and the software window surface share the window, the last software frame has to be out first
+			m_pPresenter->Flush();
 
 			//1. Clear RTV & DSV
 			if (m_IsUniform)
@@ -135,77 +173,753 @@ namespace dae {
 
 			//3. Present Backbuffer (Swap)
 			m_pSwapChain->Present(0, 0);
+
+			//the software depth and the pending software frame are stale once the other rasterizer ran
+			m_HasOcclusionDepth = false;
+			m_PendingFrame = {};
 		}
 
 		if(m_CurrentRasterizerState == RasterizerState::software)
 		{
+			//throughput rasterizes the frame of the last Render while the geometry of this one is made, it acquires and presents itself
+			if (m_FrameMode == FrameMode::Throughput)
+			{
+				RasterizeSoftwarePipelined();
+				return;
+			}
 
-			//reset the buffer and background
-			ClearDepthBuffer();
-			ClearBackGround();
+			//shows the last finished frame and hands out a back buffer the present thread is done with
+			AcquireBackBuffer();
 
 			//Lock BackBuffer
 			SDL_LockSurface(m_pBackBuffer);
 
-			//convert vertices from mesh into ndc space and then convert to screenspace
-			VertexTransformationFunction();
+			RasterizeSoftware();
+
+			//@END 
+			PresentBackBuffer();
+
+			//latency shows the frame before the next one starts
+			m_pPresenter->Flush();
+
+		}
+
+	}
+
+	void Renderer::AcquireBackBuffer()
+	{
+		m_pBackBuffer = m_pPresenter->AcquireBackBuffer();
+		m_pBackBufferPixels = static_cast<uint32_t*>(m_pBackBuffer->pixels);
+
+		//every back buffer has the same format, resolved once per frame instead of once per pixel
+		m_PixelPacker = PixelPacker{ m_pBackBuffer->format };
+	}
+
+	void Renderer::PresentBackBuffer()
+	{
+		//the present thread converts it to the window format, the window update happens on this thread
+		SDL_UnlockSurface(m_pBackBuffer);
+		m_pPresenter->Present(m_pBackBuffer);
+	}
+
+	void Renderer::RasterizeSoftware()
+	{
+		//uses both sets of slots, a frame waiting for the next Render is dropped
+		m_PendingFrame = {};
+
+		//reset the buffer and background
+		ClearDepthBuffer();
+		ClearBackGround();
+
+		//the shading mode decides which varyings are transformed, carried and interpolated
+		const Varying varyings{ GetActiveVaryings() };
+
+		CullFrame();
+
+		RasterizeVisibleInstances(varyings);
+
+		//the occluders of the next frame
+		BuildOcclusionDepth(m_pCamera->viewProjectionMatrix);
+	}
+
+	void Renderer::RasterizeSoftwarePipelined()
+	{
+		const Varying varyings{ GetActiveVaryings() };
+
+		//a frame made for other varyings can not be shaded in the current mode
+		if (m_PendingFrame.isValid && m_PendingFrame.varyings != varyings) m_PendingFrame = {};
+
+		//the geometry of this frame goes into the set the pending frame does not use
+		const size_t nrOfSlots{ m_TransformedInstances.size() / 2 };
+		const size_t firstSlot{ m_PendingFrame.isValid && m_PendingFrame.firstSlot == 0 ? nrOfSlots : 0 };
+
+		//culling and the vertex stage of this frame run on the workers while this thread rasterizes the frame of the last Render
+		//the culling reads the occlusion depth built before this Render, the one of the frame before the pending one
+		bool isPipelined{};
+		JobCounter geometryJob{};
+
+		JobSystem::Run(geometryJob, [&]()
+		{
+			CullFrame();
+
+			//only a frame that fits in one set of slots keeps its geometry until the next Render
+			isPipelined = m_VisibleInstances.size() <= nrOfSlots;
+
+			if (!isPipelined) return;
+
+			JobSystem::ParallelFor(m_VisibleInstances.size(), 1, [&](size_t begin, size_t end)
+			{
+				//a single instance splits its vertices over the threads instead
+				const unsigned int nrOfThreads{ m_VisibleInstances.size() == 1 ? JobSystem::GetNrOfThreads() : 1 };
+
+				for (size_t visibleIndex{ begin }; visibleIndex < end; ++visibleIndex)
+				{
+					TransformInstance(m_TransformedInstances[firstSlot + visibleIndex], m_Instances[m_VisibleInstances[visibleIndex]], varyings, nrOfThreads);
+				}
+			}, "vertex transform");
+		}, "frame geometry");
+
+		const bool hasPendingFrame{ m_PendingFrame.isValid };
+
+		if (hasPendingFrame)
+		{
+			AcquireBackBuffer();
+			SDL_LockSurface(m_pBackBuffer);
+
+			ClearDepthBuffer();
+			ClearBackGround();
+
+			m_ClusterStatistics = {};
+
+			const RenderTriangleFunction pRenderTriangle{ GetRenderTriangleFunction(m_PendingFrame.varyings, m_MathQuality, m_AddressMode) };
+
+			for (size_t slot{ m_PendingFrame.firstSlot }; slot < m_PendingFrame.firstSlot + m_PendingFrame.nrOfInstances; ++slot)
+			{
+				RasterizeTransformedInstance(m_TransformedInstances[slot], pRenderTriangle);
+			}
+
+			m_pDrawnInstance = nullptr;
+		}
+
+		JobSystem::Wait(geometryJob);
+
+		const InstanceStatistics instanceStatistics{ m_InstanceStatistics };
+
+		//built after the geometry job, it read the last one
+		//the pending frame was transformed with the camera of the last Render
+		if (hasPendingFrame)
+		{
+			BuildOcclusionDepth(m_PendingFrame.viewProjectionMatrix);
+			PresentBackBuffer();
+
+			//printed with the meshlets of the frame that was drawn
+			m_InstanceStatistics = m_PendingFrame.instanceStatistics;
+		}
+
+		m_PendingFrame = { isPipelined, varyings, firstSlot, m_VisibleInstances.size(), m_pCamera->viewProjectionMatrix, instanceStatistics };
+
+		if (isPipelined) return;
+
+		m_InstanceStatistics = instanceStatistics;
+
+		//too many visible instances to keep the geometry of the whole frame, drawn right away with the batches overlapping
+		AcquireBackBuffer();
+		SDL_LockSurface(m_pBackBuffer);
+
+		ClearDepthBuffer();
+		ClearBackGround();
+
+		RasterizeVisibleInstances(varyings);
+
+		BuildOcclusionDepth(m_pCamera->viewProjectionMatrix);
+		PresentBackBuffer();
+	}
+
+	void Renderer::CullFrame()
+	{
+		//drop the instances outside the frustum or hidden in the last frame before anything else is done for them
+		CullInstances();
+
+		//then the ones hidden behind the nearest instances of this frame
+		if (m_IsOcclusionCulling)
+		{
+			RenderOccluders();
+		}
+		else
+		{
+			m_OcclusionRasterizer.Clear();
+		}
+	}
+
+	void Renderer::TransformInstance(TransformedInstance& instance, const MeshInstance& meshInstance, Varying varyings, unsigned int nrOfThreads) const
+	{
+		instance.worldMatrix = m_pMesh->GetWorldMatrix() * meshInstance.worldMatrix;
+		instance.worldViewProjectionMatrix = instance.worldMatrix * m_pCamera->viewProjectionMatrix;
+		instance.tint = meshInstance.tint;
+		instance.lodIndex = meshInstance.lodIndex;
+
+		//drop the meshlets outside the frustum or facing away, their vertices are never transformed
+		CullMeshlets(instance);
+
+		//convert vertices from mesh into ndc space and then convert to screenspace
+		VertexTransformationFunction(instance, varyings, nrOfThreads);
+	}
+
+	void Renderer::RasterizeVisibleInstances(Varying varyings)
+	{
+		const RenderTriangleFunction pRenderTriangle{ GetRenderTriangleFunction(varyings, m_MathQuality, m_AddressMode) };
+
+		m_ClusterStatistics = {};
+
+		const unsigned int nrOfThreads{ JobSystem::GetNrOfThreads() };
+
+		//the slots are two sets of a batch each, the vertex stage of the next batch fills one set while the other is rasterized
+		const size_t nrOfSlots{ m_TransformedInstances.size() / 2 };
+		const size_t nrOfBatches{ (m_VisibleInstances.size() + nrOfSlots - 1) / nrOfSlots };
+
+		const auto getSlot = [&](size_t visibleIndex) -> TransformedInstance&
+		{
+			const size_t batch{ visibleIndex / nrOfSlots };
+			return m_TransformedInstances[(batch % 2) * nrOfSlots + visibleIndex % nrOfSlots];
+		};
+
+		const auto transformInstance = [&](size_t visibleIndex, unsigned int nrOfInstanceThreads)
+		{
+			TransformInstance(getSlot(visibleIndex), m_Instances[m_VisibleInstances[visibleIndex]], varyings, nrOfInstanceThreads);
+		};
+
+		//queues the vertex stage of a batch, one instance per job
+		const auto startBatch = [&](size_t batch, JobCounter& counter)
+		{
+			const size_t batchEnd{ std::min((batch + 1) * nrOfSlots, m_VisibleInstances.size()) };
+
+			for (size_t visibleIndex{ batch * nrOfSlots }; visibleIndex < batchEnd; ++visibleIndex)
+			{
+				JobSystem::Run(counter, [&transformInstance, visibleIndex]() { transformInstance(visibleIndex, 1); }, "vertex transform");
+			}
+		};
+
+		//a single instance splits its vertices over the threads instead
+		if (m_VisibleInstances.size() == 1)
+		{
+			transformInstance(0, nrOfThreads);
+		}
+		else if (nrOfBatches > 0)
+		{
+			JobCounter firstBatchJobs{};
+			startBatch(0, firstBatchJobs);
+			JobSystem::Wait(firstBatchJobs);
+		}
+
+		for (size_t batch{}; batch < nrOfBatches; ++batch)
+		{
+			//the geometry of the next batch runs on the workers while this thread rasterizes
+			JobCounter nextBatchJobs{};
+
+			if (batch + 1 < nrOfBatches) startBatch(batch + 1, nextBatchJobs);
+
+			//rasterize front to back, the depth buffer is shared
+			const size_t batchEnd{ std::min((batch + 1) * nrOfSlots, m_VisibleInstances.size()) };
 
-			switch (m_pMesh->GetPrimitiveTopology())
+			for (size_t visibleIndex{ batch * nrOfSlots }; visibleIndex < batchEnd; ++visibleIndex)
 			{
-			case PrimitiveTopology::TriangleList:
+				RasterizeTransformedInstance(getSlot(visibleIndex), pRenderTriangle);
+			}
+
+			JobSystem::Wait(nextBatchJobs);
+		}
+
+		m_pDrawnInstance = nullptr;
+	}
+
+	void Renderer::RasterizeTransformedInstance(const TransformedInstance& instance, RenderTriangleFunction pRenderTriangle)
+	{
+		m_pDrawnInstance = &instance;
+
+		m_ClusterStatistics.submitted += instance.clusterStatistics.submitted;
+		m_ClusterStatistics.frustumCulled += instance.clusterStatistics.frustumCulled;
+		m_ClusterStatistics.backfaceCulled += instance.clusterStatistics.backfaceCulled;
+		m_ClusterStatistics.occluded += instance.clusterStatistics.occluded;
+
+		RasterizeInstance(pRenderTriangle);
+	}
+
+	void Renderer::RasterizeInstance(RenderTriangleFunction pRenderTriangle)
+	{
+		//one band of rows per thread, the bands never touch the same pixel
+		const int bandHeight{ (m_Height + static_cast<int>(JobSystem::GetNrOfThreads()) - 1) / static_cast<int>(JobSystem::GetNrOfThreads()) };
+		const size_t nrOfBands{ static_cast<size_t>((m_Height + bandHeight - 1) / bandHeight) };
+
+		//every thread sorts a part of the triangles into the bands they touch, the frustum test and the rows are only checked once
+		const size_t nrOfParts{ JobSystem::GetNrOfThreads() };
+
+		m_BandTriangles.resize(nrOfParts * nrOfBands);
+
+		for (std::vector<BinnedTriangle>& bandTriangles : m_BandTriangles)
+		{
+			bandTriangles.clear();
+		}
+
+		const size_t nrOfItems{ GetNrOfBinItems() };
+		const size_t partSize{ std::max((nrOfItems + nrOfParts - 1) / nrOfParts, size_t{ 1 }) };
+
+		JobSystem::ParallelFor(nrOfItems, partSize, [&](size_t begin, size_t end)
+		{
+			BinTriangles(begin, end, bandHeight, std::span{ m_BandTriangles }.subspan(begin / partSize * nrOfBands, nrOfBands));
+		}, "raster binning");
+
+		//a band walks the parts in order, so the depth test sees the triangles in the same order as with one thread
+		JobSystem::ParallelFor(nrOfBands, 1, [&](size_t begin, size_t end)
+		{
+			for (size_t band{ begin }; band < end; ++band)
 			{
-				//for each triangle in the mesh
-				for (size_t vertexIndex{}; vertexIndex < m_pMesh->GetIndices().size(); vertexIndex += 3)
+				const int firstRow{ static_cast<int>(band) * bandHeight };
+				const int endRow{ std::min(firstRow + bandHeight, m_Height) };
+
+				for (size_t part{}; part < nrOfParts; ++part)
 				{
-					RenderTriangle(vertexIndex, false);
+					for (const BinnedTriangle& triangle : m_BandTriangles[part * nrOfBands + band])
+					{
+						(this->*pRenderTriangle)(triangle.index, triangle.swapVertices, triangle.objectSpaceNormal, firstRow, endRow);
+					}
 				}
+			}
+		}, "raster band");
+	}
 
+	bool Renderer::IsDrawnByMeshlets() const
+	{
+		//the meshlets and the baked object space normals only cover the full detail lod
+		return m_pMesh->GetPrimitiveTopology() == PrimitiveTopology::TriangleList && !m_pMesh->GetMeshlets().empty() && m_pDrawnInstance->lodIndex == 0;
+	}
+
+	size_t Renderer::GetNrOfBinItems() const
+	{
+		const MeshLod& lod{ m_pMesh->GetLod(m_pDrawnInstance->lodIndex) };
+
+		if (IsDrawnByMeshlets()) return m_pDrawnInstance->visibleMeshlets.size();
+
+		return m_pMesh->GetPrimitiveTopology() == PrimitiveTopology::TriangleList ? lod.indexCount / 3 : lod.indexCount - 2;
+	}
+
+	void Renderer::BinTriangles(size_t firstItem, size_t endItem, int bandHeight, std::span<std::vector<BinnedTriangle>> bands) const
+	{
+		const TransformedInstance& instance{ *m_pDrawnInstance };
+
+		switch (m_pMesh->GetPrimitiveTopology())
+		{
+		case PrimitiveTopology::TriangleList:
+		{
+			if (!IsDrawnByMeshlets())
+			{
+				const MeshLod& lod{ m_pMesh->GetLod(instance.lodIndex) };
+				const bool isFullDetail{ instance.lodIndex == 0 };
+
+				//for each triangle in the lod
+				for (size_t triangle{ firstItem }; triangle < endItem; ++triangle)
+				{
+					const size_t vertexIndex{ lod.indexOffset + triangle * 3 };
+
+					BinTriangle(vertexIndex, false, isFullDetail && m_ObjectSpaceTriangles[vertexIndex / 3], bandHeight, bands);
+				}
+
+				break;
 			}
-			break;
 
-			case PrimitiveTopology::TriangleStrip:
+			const std::span<const Meshlet> meshlets{ m_pMesh->GetMeshlets() };
+
+			//for each triangle in the visible meshlets
+			for (size_t visibleIndex{ firstItem }; visibleIndex < endItem; ++visibleIndex)
 			{
-				for (size_t vertexIndex{}; vertexIndex < m_pMesh->GetIndices().size() - 2; ++vertexIndex)
+				const Meshlet& meshlet{ meshlets[instance.visibleMeshlets[visibleIndex]] };
+
+				for (size_t triangle{ meshlet.triangleOffset }; triangle < meshlet.triangleOffset + meshlet.triangleCount; ++triangle)
 				{
-					RenderTriangle(vertexIndex, vertexIndex % 2);
+					BinTriangle(triangle * 3, false, m_ObjectSpaceTriangles[triangle], bandHeight, bands);
 				}
 			}
-			break;
 
+		}
+		break;
+
+		case PrimitiveTopology::TriangleStrip:
+		{
+			for (size_t vertexIndex{ firstItem }; vertexIndex < endItem; ++vertexIndex)
+			{
+				//the baked triangle flags are per list triangle, strips keep the tangent space path
+				BinTriangle(vertexIndex, vertexIndex % 2, false, bandHeight, bands);
 			}
+		}
+		break;
 
-			//@END 
-			//Update SDL Surface
-			SDL_UnlockSurface(m_pBackBuffer);
-			SDL_BlitSurface(m_pBackBuffer, nullptr, m_pFrontBuffer, nullptr);
-			SDL_UpdateWindowSurface(m_pWindow);
+		}
+	}
 
+	void Renderer::BinTriangle(size_t index, bool swapVertices, bool objectSpaceNormal, int bandHeight, std::span<std::vector<BinnedTriangle>> bands) const
+	{
+		const std::span<const uint32_t> indices{ m_pMesh->GetIndices() };
+
+		const uint32_t index0{ indices[index] };
+		const uint32_t index1{ indices[index + 1 + swapVertices] };
+		const uint32_t index2{ indices[index + 1 + !swapVertices] };
+
+		//has same index twice
+		if (index0 == index1 || index1 == index2 || index0 == index2) return;
+
+		const TransformedInstance& instance{ *m_pDrawnInstance };
+
+		const Vertex_Screen& vertex_ScreenV0{ instance.screenVertices[index0] };
+		const Vertex_Screen& vertex_ScreenV1{ instance.screenVertices[index1] };
+		const Vertex_Screen& vertex_ScreenV2{ instance.screenVertices[index2] };
+
+		if (IsOutOfFrustrum(vertex_ScreenV0) || IsOutOfFrustrum(vertex_ScreenV1) || IsOutOfFrustrum(vertex_ScreenV2)) return;
+
+		//the rows RenderTriangle can write, with the margin of its bounding box
+		const float minRow{ std::min(vertex_ScreenV0.position.y, std::min(vertex_ScreenV1.position.y, vertex_ScreenV2.position.y)) - m_BoundingMargin };
+		const float maxRow{ std::max(vertex_ScreenV0.position.y, std::max(vertex_ScreenV1.position.y, vertex_ScreenV2.position.y)) + m_BoundingMargin };
+
+		const int lastBand{ static_cast<int>(bands.size()) - 1 };
+		const int firstTouched{ std::clamp(static_cast<int>(std::floor(minRow / static_cast<float>(bandHeight))), 0, lastBand) };
+		const int lastTouched{ std::clamp(static_cast<int>(std::floor(maxRow / static_cast<float>(bandHeight))), 0, lastBand) };
+
+		for (int band{ firstTouched }; band <= lastTouched; ++band)
+		{
+			bands[band].push_back(BinnedTriangle{ index, swapVertices, objectSpaceNormal });
+		}
+	}
+
+	void Renderer::UpdateInstanceBvh()
+	{
+		const bool isWorldChanged{ m_InstanceBvhWorldVersion != m_pMesh->GetWorldVersion() };
+
+		if (!m_IsInstanceBvhStale && !m_AreInstanceBoxesStale && !isWorldChanged) return;
+
+		const VertexQuantization::Bounds& bounds{ m_pMesh->GetBounds() };
+		const Vector3 boundsMax{ bounds.min + bounds.extent };
+
+		m_InstanceBoxes.resize(m_Instances.size());
+
+		for (size_t instanceIndex{}; instanceIndex < m_Instances.size(); ++instanceIndex)
+		{
+			m_InstanceBoxes[instanceIndex] = BoundingBox::Transform(bounds.min, boundsMax, m_pMesh->GetWorldMatrix() * m_Instances[instanceIndex].worldMatrix);
+		}
+
+		//the rotation of the vehicle turns every instance around its own place, the tree stays good and only the boxes change
+		if (m_IsInstanceBvhStale)
+		{
+			m_InstanceBvh.Build(m_InstanceBoxes);
+		}
+		else
+		{
+			m_InstanceBvh.Refit(m_InstanceBoxes);
+		}
+
+		m_IsInstanceBvhStale = false;
+		m_AreInstanceBoxesStale = false;
+		m_InstanceBvhWorldVersion = m_pMesh->GetWorldVersion();
+	}
+
+	void Renderer::CullInstances()
+	{
+		m_VisibleInstances.clear();
+		m_InstanceStatistics = { static_cast<uint32_t>(m_Instances.size()) };
+
+		UpdateInstanceBvh();
+
+		const bool canOcclude{ m_IsOcclusionCulling && m_HasOcclusionDepth };
+
+		//world space planes, the boxes of the bvh are world space
+		const SceneBvh::QueryStatistics statistics{ m_InstanceBvh.Query(Frustum::FromMatrix(m_pCamera->viewProjectionMatrix),
+			[&](const BoundingBox& box) { return canOcclude && IsOccluded(box); },
+			[&](uint32_t instanceIndex) { m_VisibleInstances.push_back(instanceIndex); }) };
+
+		m_InstanceStatistics.frustumCulled = statistics.frustumCulled;
+		m_InstanceStatistics.occluded = statistics.occluded;
+
+		//front to back, the near instances fill the depth buffer first and hide more pixels of the ones behind them
+		const auto distanceSquared = [&](uint32_t instanceIndex) { return (m_InstanceBoxes[instanceIndex].GetCenter() - m_pCamera->origin).SqrMagnitude(); };
+
+		std::sort(m_VisibleInstances.begin(), m_VisibleInstances.end(), [&](uint32_t a, uint32_t b) { return distanceSquared(a) < distanceSquared(b); });
+
+		for (const uint32_t instanceIndex : m_VisibleInstances)
+		{
+			MeshInstance& instance{ m_Instances[instanceIndex] };
+
+			instance.lodIndex = m_IsAutomaticLod ? m_pMesh->SelectLod(m_pMesh->GetWorldMatrix() * instance.worldMatrix, instance.lodIndex, m_pCamera->origin, GetPixelsPerUnit(), m_LodPixelError, m_LodHysteresis) : 0;
+		}
+	}
+
+	void Renderer::BuildOcclusionDepth(const Matrix& viewProjectionMatrix)
+	{
+		m_OcclusionWidth = (m_Width + m_OcclusionTileSize - 1) / m_OcclusionTileSize;
+		m_OcclusionHeight = (m_Height + m_OcclusionTileSize - 1) / m_OcclusionTileSize;
+
+		m_OcclusionDepth.assign(static_cast<size_t>(m_OcclusionWidth) * m_OcclusionHeight, 0.f);
+
+		for (int py{}; py < m_Height; ++py)
+		{
+			float* pTileRow{ &m_OcclusionDepth[static_cast<size_t>(py / m_OcclusionTileSize) * m_OcclusionWidth] };
+			const float* pDepthRow{ m_pDepthBufferPixels + static_cast<size_t>(py) * m_Width };
+
+			for (int px{}; px < m_Width; ++px)
+			{
+				float& tileDepth{ pTileRow[px / m_OcclusionTileSize] };
+				tileDepth = std::max(tileDepth, pDepthRow[px]);
+			}
 		}
 
+		m_OcclusionViewProjectionMatrix = viewProjectionMatrix;
+		m_HasOcclusionDepth = true;
 	}
 
-	void Renderer::RenderTriangle(const size_t& index, const bool swapVertices) const
+	bool Renderer::IsOccluded(const BoundingBox& box) const
+	{
+		//project the corners with the camera the depth was rendered with
+		ScreenBounds bounds{};
+
+		if (!OcclusionRasterizer::ProjectBox(box.min, box.max, m_OcclusionViewProjectionMatrix, static_cast<float>(m_Width), static_cast<float>(m_Height), bounds)) return false;
+
+		//off screen in the previous frame, nothing is known about it
+		if (bounds.maxX < 0.f || bounds.maxY < 0.f || bounds.minX > static_cast<float>(m_Width - 1) || bounds.minY > static_cast<float>(m_Height - 1)) return false;
+
+		const int minTileX{ std::max(static_cast<int>(bounds.minX), 0) / m_OcclusionTileSize };
+		const int minTileY{ std::max(static_cast<int>(bounds.minY), 0) / m_OcclusionTileSize };
+		const int maxTileX{ std::min(static_cast<int>(bounds.maxX), m_Width - 1) / m_OcclusionTileSize };
+		const int maxTileY{ std::min(static_cast<int>(bounds.maxY), m_Height - 1) / m_OcclusionTileSize };
+
+		for (int tileY{ minTileY }; tileY <= maxTileY; ++tileY)
+		{
+			for (int tileX{ minTileX }; tileX <= maxTileX; ++tileX)
+			{
+				if (m_OcclusionDepth[static_cast<size_t>(tileY) * m_OcclusionWidth + tileX] >= bounds.nearestDepth) return false;
+			}
+		}
+
+		return true;
+	}
+
+	void Renderer::RenderOccluders()
+	{
+		m_OcclusionRasterizer.Clear();
+
+		const std::span<const PackedVertex> vertices{ m_pMesh->GetPackedVertices() };
+		const std::span<const uint32_t> indices{ m_pMesh->GetIndices() };
+
+		constexpr size_t vertexStride{ sizeof(PackedVertex) / sizeof(uint16_t) };
+		const std::span<const uint16_t> positionStream{ reinterpret_cast<const uint16_t*>(vertices.data()) + offsetof(PackedVertex, position) / sizeof(uint16_t), vertices.size() * vertexStride };
+
+		//the visible instances are sorted front to back, the first large ones hide the most
+		for (const uint32_t instanceIndex : m_VisibleInstances)
+		{
+			if (m_InstanceStatistics.occluders == m_MaxNrOfOccluders) break;
+
+			const BoundingBox& box{ m_InstanceBoxes[instanceIndex] };
+			const float radius{ (box.max - box.min).Magnitude() / 2 };
+
+			if (radius < m_MinOccluderSize * (box.GetCenter() - m_pCamera->origin).Magnitude()) continue;
+
+			const Matrix worldMatrix{ m_pMesh->GetWorldMatrix() * m_Instances[instanceIndex].worldMatrix };
+
+			//always the full mesh, a simplified lod can close holes and hide what is seen through them
+			const MeshLod& lod{ m_pMesh->GetLod(0) };
+
+			//only the positions, projected straight into ndc
+			m_OccluderStreams.resize(size_t{ lod.vertexCount } * 4);
+
+			const auto outputStream = [&](size_t stream) { return std::span<float>{ m_OccluderStreams.data() + stream * lod.vertexCount, lod.vertexCount }; };
+			const Vector4Streams positions{ outputStream(0), outputStream(1), outputStream(2), outputStream(3) };
+
+			(m_pMesh->GetDequantizationMatrix() * worldMatrix * m_pCamera->viewProjectionMatrix).TransformAndProject(positionStream.subspan(size_t{ lod.vertexOffset } * vertexStride, size_t{ lod.vertexCount } * vertexStride), vertexStride, positions);
+
+			m_OcclusionRasterizer.RenderTriangles(positions, indices.subspan(lod.indexOffset, lod.indexCount), lod.vertexOffset);
+
+			++m_InstanceStatistics.occluders;
+		}
+
+		//an occluder can not hide itself, its box is always in front of its own surface
+		std::erase_if(m_VisibleInstances, [&](uint32_t instanceIndex)
+		{
+			const BoundingBox& box{ m_InstanceBoxes[instanceIndex] };
+
+			if (!m_OcclusionRasterizer.IsBoxOccluded(box.min, box.max, m_pCamera->viewProjectionMatrix)) return false;
+
+			++m_InstanceStatistics.occluderCulled;
+			return true;
+		});
+	}
+
+	void Renderer::CycleInstanceGrid()
+	{
+		static constexpr uint32_t gridSizes[]{ 1, 10, 32 };
+		static constexpr float spacing{ 30.f };
+
+		m_InstanceGridIndex = (m_InstanceGridIndex + 1) % std::size(gridSizes);
+
+		const uint32_t gridSize{ gridSizes[m_InstanceGridIndex] };
+		const int firstColumn{ -static_cast<int>(gridSize / 2) };
+
+		//rows go away from the camera, the vehicle itself stays in the first row
+		m_Instances.clear();
+		m_Instances.reserve(size_t{ gridSize } * gridSize);
+
+		for (uint32_t row{}; row < gridSize; ++row)
+		{
+			for (int column{ firstColumn }; column < firstColumn + static_cast<int>(gridSize); ++column)
+			{
+				const ColorRGB tint{ (row + column) % 2 == 0 ? colors::White : ColorRGB{ 0.6f, 0.8f, 1.f } };
+
+				m_Instances.push_back(MeshInstance{ Matrix::CreateTranslation(static_cast<float>(column) * spacing, 0.f, static_cast<float>(row) * spacing), tint });
+			}
+		}
+
+		m_IsInstanceBvhStale = true;
+
+		std::cout << "\033[35m"; // TEXT COLOR
+		std::cout << "**(SOFTWARE) Instances " << m_Instances.size() << "\n";
+	}
+
+	Varying Renderer::GetActiveVaryings() const
+	{
+		//the depth visualization and the bounding boxes never reach the pixel shading
+		if (m_ShowDepthBuffer || m_ShowBoundingBoxes) return Varying::None;
+
+		//normal mapping samples the normal map and builds the tangent frame
+		Varying varyings{ m_ShowNormal ? Varying::Normal | Varying::Tangent | Varying::UV : Varying::Normal };
+
+		switch (m_CurrentSoftwareMode)
+		{
+			case SoftwareModes::ObservedArea:
+				break;
+			case SoftwareModes::Diffuse:
+				varyings = varyings | Varying::UV;
+				break;
+			case SoftwareModes::Specular:
+			case SoftwareModes::Combined:
+				varyings = varyings | Varying::UV | Varying::ViewDirection;
+				break;
+		}
+
+		return varyings;
+	}
+
+	Renderer::RenderTriangleFunction Renderer::GetRenderTriangleFunction(Varying varyings, MathQuality quality, Texture::AddressMode addressMode)
+	{
+		constexpr size_t nrOfQualities{ 2 };
+		constexpr size_t nrOfAddressModes{ 3 };
+
+		//one instantiation per varying set, math quality and address mode, the varying set changes fastest
+		static constexpr auto renderTriangleFunctions{ []<size_t... indices>(std::index_sequence<indices...>)
+		{
+			return std::array<RenderTriangleFunction, sizeof...(indices)>
+			{
+				&Renderer::RenderTriangle<static_cast<Varying>(indices % VaryingSetCount), static_cast<MathQuality>(indices / VaryingSetCount % nrOfQualities), static_cast<Texture::AddressMode>(indices / (VaryingSetCount * nrOfQualities))>...
+			};
+		}(std::make_index_sequence<VaryingSetCount * nrOfQualities * nrOfAddressModes>{}) };
+
+		return renderTriangleFunctions[(static_cast<size_t>(addressMode) * nrOfQualities + static_cast<size_t>(quality)) * VaryingSetCount + static_cast<size_t>(varyings)];
+	}
+
+	void Renderer::CompareMathQuality()
+	{
+		const MathQuality quality{ m_MathQuality };
+
+		//drawn but never presented
+		AcquireBackBuffer();
+
+		SDL_LockSurface(m_pBackBuffer);
+
+		//reference frame
+		m_MathQuality = MathQuality::Exact;
+		RasterizeSoftware();
+
+		const std::vector<uint32_t> exactPixels(m_pBackBufferPixels, m_pBackBufferPixels + m_NrOfPixels);
+
+		m_MathQuality = MathQuality::Fast;
+		RasterizeSoftware();
+
+		SDL_UnlockSurface(m_pBackBuffer);
+
+		m_MathQuality = quality;
+
+		//compare every channel of both frames
+		int maxError{};
+		uint64_t totalError{};
+		int differentPixels{};
+
+		for (int pixelIdx{}; pixelIdx < m_NrOfPixels; ++pixelIdx)
+		{
+			Uint8 exact[3]{};
+			Uint8 fast[3]{};
+
+			SDL_GetRGB(exactPixels[pixelIdx], m_pBackBuffer->format, &exact[0], &exact[1], &exact[2]);
+			SDL_GetRGB(m_pBackBufferPixels[pixelIdx], m_pBackBuffer->format, &fast[0], &fast[1], &fast[2]);
+
+			int pixelError{};
+
+			for (int channel{}; channel < 3; ++channel)
+			{
+				const int error{ std::abs(static_cast<int>(exact[channel]) - static_cast<int>(fast[channel])) };
+
+				pixelError = std::max(pixelError, error);
+				totalError += error;
+			}
+
+			maxError = std::max(maxError, pixelError);
+			differentPixels += pixelError > 0;
+		}
+
+		const float meanError{ static_cast<float>(totalError) / static_cast<float>(m_NrOfPixels * 3) };
+
+		std::cout << (maxError <= m_MathQualityErrorBound ? "\033[32m" : "\033[31m"); // TEXT COLOR
+		std::cout << "Fast vs exact: max error " << maxError << " / 255 (bound " << m_MathQualityErrorBound << "), mean error " << meanError;
+		std::cout << ", " << differentPixels << " pixels differ " << (maxError <= m_MathQualityErrorBound ? "PASSED" : "FAILED") << "\n";
+	}
+
+	template<Varying varyings, MathQuality quality, Texture::AddressMode addressMode>
+	void Renderer::RenderTriangle(const size_t& index, const bool swapVertices, const bool objectSpaceNormal, const int firstRow, const int endRow) const
 	{
 		//calculate the indexes of the vertices of the triangle
 		const size_t index0{ m_pMesh->GetIndices()[index] };
 		const size_t index1{ m_pMesh->GetIndices()[index + 1 + swapVertices] };
 		const size_t index2{ m_pMesh->GetIndices()[index + 1 + !swapVertices] };
 
-		//has same index twice return
-		if (index0 == index1 || index1 == index2 || index0 == index2) return;
+		//get the projected vertices of the indexes, BinTriangle already dropped the degenerate ones and the ones outside the frustum or the band
+		const TransformedInstance& instance{ *m_pDrawnInstance };
+
+		const Vertex_Screen vertex_ScreenV0{ instance.screenVertices[index0] };
+		const Vertex_Screen vertex_ScreenV1{ instance.screenVertices[index1] };
+		const Vertex_Screen vertex_ScreenV2{ instance.screenVertices[index2] };
 
-		//get the vertex of the indexes
-		const Vertex_Out vertex_OutV0{ m_Vertices_Out[index0] };
-		const Vertex_Out vertex_OutV1{ m_Vertices_Out[index1] };
-		const Vertex_Out vertex_OutV2{ m_Vertices_Out[index2] };
+		//get the varyings of the vertices, only the ones the shading mode reads
+		Vertex_Out vertex_OutV0{};
+		Vertex_Out vertex_OutV1{};
+		Vertex_Out vertex_OutV2{};
 
-		//if out of frustrum return
-		if (IsOutOfFrustrum(vertex_OutV0) || IsOutOfFrustrum(vertex_OutV1) || IsOutOfFrustrum(vertex_OutV2)) return;
+		if constexpr (HasVarying(varyings, Varying::Normal))
+		{
+			vertex_OutV0.normal = instance.normals[index0];
+			vertex_OutV1.normal = instance.normals[index1];
+			vertex_OutV2.normal = instance.normals[index2];
+		}
+
+		if constexpr (HasVarying(varyings, Varying::Tangent))
+		{
+			vertex_OutV0.tangent = instance.tangents[index0];
+			vertex_OutV1.tangent = instance.tangents[index1];
+			vertex_OutV2.tangent = instance.tangents[index2];
+		}
+
+		if constexpr (HasVarying(varyings, Varying::ViewDirection))
+		{
+			vertex_OutV0.viewDirection = instance.viewDirections[index0];
+			vertex_OutV1.viewDirection = instance.viewDirections[index1];
+			vertex_OutV2.viewDirection = instance.viewDirections[index2];
+		}
 
 		//calc vertices
-		const Vector2 v0{ m_Vertices_ScreenSpace[index0] };
-		const Vector2 v1{ m_Vertices_ScreenSpace[index1] };
-		const Vector2 v2{ m_Vertices_ScreenSpace[index2] };
+		const Vector2 v0{ vertex_ScreenV0.position };
+		const Vector2 v1{ vertex_ScreenV1.position };
+		const Vector2 v2{ vertex_ScreenV2.position };
 
 		//calculate the edges of the triangle
 		const Vector2 edgeV0V1{ v1 - v0 };
@@ -227,10 +941,15 @@ namespace dae {
 
 		// calc the start and end of of the pixels of the triangle
 		const int minX{ std::clamp(static_cast<int>(boundingBox.minAABB.x - m_BoundingMargin),0, m_Width) };
-		const int minY{ std::clamp(static_cast<int>(boundingBox.minAABB.y - m_BoundingMargin),0, m_Height) };
+		const int minY{ std::clamp(static_cast<int>(boundingBox.minAABB.y - m_BoundingMargin),firstRow, endRow) };
 
 		const int maxX{ std::clamp(static_cast<int>(boundingBox.maxAABB.x + m_BoundingMargin),0, m_Width) };
-		const int maxY{ std::clamp(static_cast<int>(boundingBox.maxAABB.y + m_BoundingMargin),0, m_Height) };
+		const int maxY{ std::clamp(static_cast<int>(boundingBox.maxAABB.y + m_BoundingMargin),firstRow, endRow) };
+
+		//shaded pixels are packed and written 8 at a time, the rest when the triangle is done
+		PixelBatch pixelOutput{ m_PixelPacker, m_pBackBufferPixels };
+
+		const uint32_t boundingBoxPixel{ m_PixelPacker.Pack(255, 255, 255) };
 
 		for (int px{ minX }; px < maxX; ++px)
 		{
@@ -242,10 +961,7 @@ namespace dae {
 				//only render the pixels of the bounding box
 				if (m_ShowBoundingBoxes)
 				{
-					m_pBackBufferPixels[pixelIndex] = SDL_MapRGB(m_pBackBuffer->format,
-						static_cast<uint8_t>(255),
-						static_cast<uint8_t>(255),
-						static_cast<uint8_t>(255));
+					m_pBackBufferPixels[pixelIndex] = boundingBoxPixel;
 					continue;
 				}
 				//calc current pixel
@@ -270,9 +986,9 @@ namespace dae {
 				const float weightV2{ edge0 * invTriangleArea };
 
 				//calc barycentric depths
-				float invDepthV0{ CalculateDepth(vertex_OutV0, false) };
-				float invDepthV1{ CalculateDepth(vertex_OutV1, false) };
-				float invDepthV2{ CalculateDepth(vertex_OutV2, false) };
+				float invDepthV0{ CalculateDepth(vertex_ScreenV0, false) };
+				float invDepthV1{ CalculateDepth(vertex_ScreenV1, false) };
+				float invDepthV2{ CalculateDepth(vertex_ScreenV2, false) };
 
 				//calc z depth
 				const float interpolateDepthZ{ CalculateInterpolateDepth(weightV0, weightV1, weightV2, invDepthV0, invDepthV1, invDepthV2) };
@@ -296,59 +1012,69 @@ namespace dae {
 					Vertex_Out pixelInformation{};
 
 					//calculate w depth
-					invDepthV0 = CalculateDepth(vertex_OutV0, true);
-					invDepthV1 = CalculateDepth(vertex_OutV1, true);
-					invDepthV2 = CalculateDepth(vertex_OutV2, true);
+					invDepthV0 = CalculateDepth(vertex_ScreenV0, true);
+					invDepthV1 = CalculateDepth(vertex_ScreenV1, true);
+					invDepthV2 = CalculateDepth(vertex_ScreenV2, true);
 
 					const float interpolateDepthW{ CalculateInterpolateDepth(weightV0, weightV1, weightV2, invDepthV0, invDepthV1, invDepthV2) };
 
-					//calculate the uv of the current pixel
-					const Vector2 uvPixel
+					if constexpr (HasVarying(varyings, Varying::UV))
 					{
-							(CalcUVComponent(weightV0, invDepthV0, index0)
-						+ CalcUVComponent(weightV1, invDepthV1, index1)
-						+ CalcUVComponent(weightV2, invDepthV2, index2))
-						* interpolateDepthW
-					};
-
-					//save it to the uv
-					pixelInformation.uv = uvPixel;
+						//calculate the uv of the current pixel
+						const Vector2 uvPixel
+						{
+								(CalcUVComponent(weightV0, invDepthV0, index0)
+							+ CalcUVComponent(weightV1, invDepthV1, index1)
+							+ CalcUVComponent(weightV2, invDepthV2, index2))
+							* interpolateDepthW
+						};
+
+						//save it to the uv
+						pixelInformation.uv = uvPixel;
+					}
 
 					//calculate the rest of the pixelInformation
 
-					InterpolatePixelInfo(pixelInformation, vertex_OutV0, vertex_OutV1, vertex_OutV2, weightV0, weightV1, weightV2, interpolateDepthW);
+					InterpolatePixelInfo<varyings, quality>(pixelInformation, vertex_OutV0, vertex_OutV1, vertex_OutV2, vertex_ScreenV0, vertex_ScreenV1, vertex_ScreenV2, weightV0, weightV1, weightV2, interpolateDepthW);
 
 					//calculate shading of currennt pixel
-					PixelShading(pixelInformation, finalColor);
+					PixelShading<quality, addressMode>(pixelInformation, finalColor, objectSpaceNormal);
 
 				}
 
 				//show pixel to screen with given color
-				ConvertColorToPixel(finalColor, pixelIndex);
+				pixelOutput.Add(pixelIndex, finalColor);
 
 			}
 		}
 	}
 
-	void Renderer::PixelShading(const Vertex_Out& vOut, ColorRGB& finalColor) const
+	template<MathQuality quality, Texture::AddressMode addressMode>
+	void Renderer::PixelShading(const Vertex_Out& vOut, ColorRGB& finalColor, const bool objectSpaceNormal) const
 	{
 		//store normal
 		Vector3 sampledNormal{ vOut.normal };
 
-		if (m_ShowNormal)
+		if (m_ShowNormal && objectSpaceNormal)
+		{
+			//baked object space normal, only needs the world rotation
+			sampledNormal = m_pObjectSpaceNormalTexture->SampleVector3<addressMode>(vOut.uv);
+			sampledNormal = 2 * sampledNormal - Vector3::Identity;
+
+			sampledNormal = m_pDrawnInstance->worldMatrix.TransformVector(sampledNormal);
+		}
+		else if (m_ShowNormal)
 		{
 			//calc binormal
 			const Vector3 binormal{ Vector3::Cross(vOut.normal, vOut.tangent) };
 			//create matrix out of tangent binormal and normal
-			const Matrix tangentSpaceAxis{ vOut.tangent, binormal.Normalized(), vOut.normal, Vector3::Zero };
+			const Matrix tangentSpaceAxis{ vOut.tangent, NormalizeVector<quality>(binormal), vOut.normal, Vector3::Zero };
 
 			//sample color of the uv of the texture and clamp it between -1 and 1
-			sampledNormal = m_pNormalTexture->SampleVector3(vOut.uv);
+			sampledNormal = m_pNormalTexture->SampleVector3<addressMode>(vOut.uv);
 			sampledNormal = 2 * sampledNormal - Vector3::Identity;
 
-			sampledNormal = tangentSpaceAxis.TransformVector(sampledNormal);
-
-			sampledNormal.Normalize();
+			sampledNormal = NormalizeVector<quality>(tangentSpaceAxis.TransformVector(sampledNormal));
 		}
 
 		//calc observedArea
@@ -364,13 +1090,13 @@ namespace dae {
 			case SoftwareModes::Diffuse:
 			{
 					//calc lamber shader with  the observer area and lightintensity
-				finalColor = (m_pDiffuseTexture->Sample(vOut.uv) * m_KD / PI) * m_LightIntensity * observedArea;
+				finalColor = (m_pDiffuseTexture->Sample<addressMode>(vOut.uv) * m_pDrawnInstance->tint * m_KD / PI) * m_LightIntensity * observedArea;
 			}
 			break;
 			case SoftwareModes::Specular:
 			{
 				//calc calc color of the specular
-				const ColorRGB specularColor{ CalculateSpecular(sampledNormal, vOut) };
+				const ColorRGB specularColor{ CalculateSpecular<quality, addressMode>(sampledNormal, vOut) };
 
 				finalColor = specularColor * observedArea;
 			}
@@ -378,9 +1104,9 @@ namespace dae {
 			case SoftwareModes::Combined:
 			{
 				//sum them all up to combine them
-				const ColorRGB specularColor{ CalculateSpecular(sampledNormal, vOut) };
+				const ColorRGB specularColor{ CalculateSpecular<quality, addressMode>(sampledNormal, vOut) };
 
-				const ColorRGB diffuseColor{ (m_pDiffuseTexture->Sample(vOut.uv) * m_KD / PI) * m_LightIntensity };
+				const ColorRGB diffuseColor{ (m_pDiffuseTexture->Sample<addressMode>(vOut.uv) * m_pDrawnInstance->tint * m_KD / PI) * m_LightIntensity };
 
 				finalColor = diffuseColor * observedArea + specularColor;
 			}
@@ -415,61 +1141,287 @@ namespace dae {
 		return false;
 	}
 
-	void Renderer::VertexTransformationFunction()
+	void Renderer::CullMeshlets(TransformedInstance& instance) const
 	{
-		//clear the vertices
-		m_Vertices_ScreenSpace.clear();
+		const std::span<const Meshlet> meshlets{ m_pMesh->GetMeshlets() };
+		const MeshLod& lod{ m_pMesh->GetLod(instance.lodIndex) };
 
-		m_Vertices_Out.clear();
+		instance.visibleMeshlets.clear();
+		instance.visibleVertexRanges.clear();
 
-		//calc transform matrix of the mesh
-		const Matrix worldViewProjectionMatrix{ m_pMesh->GetWorldMatrix() * m_pCamera->viewMatrix * m_pCamera->projectionMatrix };
+		//strips, meshes without meshlets and the simplified lods transform every vertex of the lod
+		if (meshlets.empty() || m_pMesh->GetPrimitiveTopology() != PrimitiveTopology::TriangleList || instance.lodIndex != 0)
+		{
+			instance.clusterStatistics = {};
+			instance.visibleVertexRanges.emplace_back(lod.vertexOffset, lod.vertexCount);
+			return;
+		}
+
+		instance.clusterStatistics = { static_cast<uint32_t>(meshlets.size()) };
+
+		//the bounds are in object space, so are the planes of the world view projection matrix
+		const Frustum frustum{ Frustum::FromMatrix(instance.worldViewProjectionMatrix) };
+		//the vehicle and the instances only rotate and move, the transpose of the rotation is enough
+		const Vector3 cameraPosition{ Matrix::InverseRigid(instance.worldMatrix).TransformPoint(m_pCamera->origin) };
+
+		//culling the front faces flips the cone, without culling it is never tested
+		const float coneSign{ m_CurrentCullMode == CullMode::front ? -1.f : 1.f };
 
-		for (const Vertex& vertex : m_pMesh->GetVertices())
+		//the occlusion buffer is only read here, the instances of a batch test against it on their own threads
+		const bool isOcclusionTested{ m_IsOcclusionCulling && m_OcclusionRasterizer.GetNrOfTriangles() > 0 };
+
+		for (uint32_t meshletIndex{}; meshletIndex < meshlets.size(); ++meshletIndex)
 		{
-			//calc viewDirection
-			Vector3 viewDirection{ m_pMesh->GetWorldMatrix().TransformPoint(vertex.position) - m_pCamera->origin };
-			viewDirection.Normalize();
+			const Meshlet& meshlet{ meshlets[meshletIndex] };
 
-			//fill in vertex information
-			Vertex_Out temp
+			if (frustum.IsSphereOutside(meshlet.center, meshlet.radius))
 			{
-				//transform vertex with the matrix
-				worldViewProjectionMatrix.TransformPoint({vertex.position, 1.f}),
-				//transform normal and tangent of the vertex
-				m_pMesh->GetWorldMatrix().TransformVector(vertex.normal).Normalized(),
-				m_pMesh->GetWorldMatrix().TransformVector(vertex.tangent).Normalized(),
-				vertex.uv,
-				vertex.color,
-				viewDirection
-			};
-			//perspective divide
-			//divide position by w
-			temp.position.x /= temp.position.w;
-			temp.position.y /= temp.position.w;
-			temp.position.z /= temp.position.w;
+				++instance.clusterStatistics.frustumCulled;
+				continue;
+			}
 
-			//add to the vertices_out
-			m_Vertices_Out.emplace_back(temp);
+			//every triangle faces away when the camera is inside the cone behind the meshlet, widened by the sphere
+			if (m_CurrentCullMode != CullMode::none && meshlet.coneCutoff < 1.f)
+			{
+				const Vector3 toMeshlet{ meshlet.center - cameraPosition };
+
+				if (coneSign * Vector3::Dot(toMeshlet, meshlet.coneAxis) >= meshlet.coneCutoff * toMeshlet.Magnitude() + meshlet.radius)
+				{
+					++instance.clusterStatistics.backfaceCulled;
+					continue;
+				}
+			}
+
+			//the sphere is in object space, the box around it is projected with the world view projection matrix
+			if (isOcclusionTested && m_OcclusionRasterizer.IsBoxOccluded(meshlet.center - Vector3{ meshlet.radius, meshlet.radius, meshlet.radius }, meshlet.center + Vector3{ meshlet.radius, meshlet.radius, meshlet.radius }, instance.worldViewProjectionMatrix))
+			{
+				++instance.clusterStatistics.occluded;
+				continue;
+			}
+
+			instance.visibleMeshlets.emplace_back(meshletIndex);
+
+			//meshlets are stored in vertex order, extend the last range when they touch
+			if (!instance.visibleVertexRanges.empty() && instance.visibleVertexRanges.back().first + instance.visibleVertexRanges.back().second == meshlet.vertexOffset)
+			{
+				instance.visibleVertexRanges.back().second += meshlet.vertexCount;
+			}
+			else
+			{
+				instance.visibleVertexRanges.emplace_back(meshlet.vertexOffset, meshlet.vertexCount);
+			}
+		}
+	}
+
+	std::vector<Renderer::ThreadStageTimings> Renderer::m_StageTimings{};
+
+	void Renderer::AddStageTiming(const JobTiming& timing)
+	{
+		ThreadStageTimings& thread{ m_StageTimings[timing.threadIndex] };
+
+		//the literal of a name is the same for every job of a stage, comparing the pointers is enough
+		const uint32_t nrOfStages{ thread.nrOfStages.load(std::memory_order_relaxed) };
+
+		uint32_t stageIndex{};
+
+		while (stageIndex < nrOfStages && thread.stages[stageIndex].pName.load(std::memory_order_relaxed) != timing.pName)
+		{
+			++stageIndex;
+		}
+
+		if (stageIndex == nrOfStages)
+		{
+			//a full table drops the timings of new names
+			if (nrOfStages == ThreadStageTimings::m_MaxStages) return;
+
+			//published after the name, the print only reads the stages it counted
+			thread.stages[stageIndex].pName.store(timing.pName, std::memory_order_relaxed);
+			thread.nrOfStages.store(nrOfStages + 1, std::memory_order_release);
+		}
+
+		StageTiming& stage{ thread.stages[stageIndex] };
+
+		stage.nrOfJobs.fetch_add(1, std::memory_order_relaxed);
+		stage.nanoseconds.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(timing.end - timing.start).count(), std::memory_order_relaxed);
+	}
+
+	void Renderer::PrintFrameStatistics()
+	{
+		std::cout << "\033[37m";
+
+		//summed over the frames since the last print, the same name can be a different literal in another file
+		std::vector<std::tuple<std::string_view, uint32_t, int64_t>> stages{};
+
+		for (ThreadStageTimings& thread : m_StageTimings)
+		{
+			const uint32_t nrOfStages{ thread.nrOfStages.load(std::memory_order_acquire) };
+
+			for (uint32_t stageIndex{}; stageIndex < nrOfStages; ++stageIndex)
+			{
+				StageTiming& stage{ thread.stages[stageIndex] };
+
+				//exchanged, a job finishing meanwhile is counted in the next print
+				const uint32_t nrOfJobs{ stage.nrOfJobs.exchange(0, std::memory_order_relaxed) };
+				const int64_t nanoseconds{ stage.nanoseconds.exchange(0, std::memory_order_relaxed) };
+
+				if (nrOfJobs == 0) continue;
+
+				const std::string_view name{ stage.pName.load(std::memory_order_relaxed) };
+
+				const auto it{ std::find_if(stages.begin(), stages.end(), [&](const auto& merged) { return std::get<0>(merged) == name; }) };
+
+				if (it == stages.end())
+				{
+					stages.emplace_back(name, nrOfJobs, nanoseconds);
+					continue;
+				}
+
+				std::get<1>(*it) += nrOfJobs;
+				std::get<2>(*it) += nanoseconds;
+			}
+		}
+
+		for (const auto& [name, nrOfJobs, nanoseconds] : stages)
+		{
+			std::cout << "Jobs " << name << ": " << nrOfJobs << " in " << static_cast<float>(nanoseconds) * 1e-6f << " ms\n";
+		}
+
+		uint32_t nrOfShown{};
+		uint32_t nrOfDropped{};
+		m_pPresenter->ResetStatistics(nrOfShown, nrOfDropped);
+
+		if (nrOfShown + nrOfDropped > 0)
+		{
+			const bool isFifo{ m_pPresenter->GetPresentMode() == FramePresenter::PresentMode::Fifo };
+
+			std::cout << "Present: " << nrOfShown << " shown, " << nrOfDropped << " dropped (" << (isFifo ? "FIFO" : "LATEST") << ", " << m_pPresenter->GetNrOfBackBuffers() << " back buffers)\n";
+		}
+
+		if (m_CurrentRasterizerState != RasterizerState::software)
+		{
+			std::cout << "LOD " << m_pMesh->GetLodIndex() << " (" << m_pMesh->GetLod().indexCount / 3 << " triangles)\n";
+			return;
 		}
 
-		//calc ndc to raster space
-		for (const Vertex_Out& vertice : m_Vertices_Out)
+		const uint32_t visibleInstances{ m_InstanceStatistics.submitted - m_InstanceStatistics.frustumCulled - m_InstanceStatistics.occluded - m_InstanceStatistics.occluderCulled };
+
+		std::cout << "Instances: " << visibleInstances << " / " << m_InstanceStatistics.submitted << " drawn (" << m_InstanceStatistics.frustumCulled << " frustum culled, " << m_InstanceStatistics.occluded << " occluded in the last frame, "
+			<< m_InstanceStatistics.occluderCulled << " behind " << m_InstanceStatistics.occluders << " occluders)\n";
+
+		if (m_ClusterStatistics.submitted == 0) return;
+
+		const uint32_t visible{ m_ClusterStatistics.submitted - m_ClusterStatistics.frustumCulled - m_ClusterStatistics.backfaceCulled - m_ClusterStatistics.occluded };
+
+		std::cout << "Meshlets: " << visible << " / " << m_ClusterStatistics.submitted << " drawn (" << m_ClusterStatistics.frustumCulled << " frustum, " << m_ClusterStatistics.backfaceCulled << " backface, " << m_ClusterStatistics.occluded << " occlusion culled)\n";
+	}
+
+	void Renderer::VertexTransformationFunction(TransformedInstance& instance, Varying varyings, unsigned int nrOfThreads) const
+	{
+		const std::span<const PackedVertex> vertices{ m_pMesh->GetPackedVertices() };
+		const size_t nrOfVertices{ vertices.size() };
+
+		//indexed by vertex, the slots of culled meshlets are left stale and never read
+		instance.screenVertices.resize(nrOfVertices);
+
+		instance.normals.resize(HasVarying(varyings, Varying::Normal) ? nrOfVertices : 0);
+		instance.tangents.resize(HasVarying(varyings, Varying::Tangent) ? nrOfVertices : 0);
+		instance.uvs.resize(HasVarying(varyings, Varying::UV) ? nrOfVertices : 0);
+		instance.viewDirections.resize(HasVarying(varyings, Varying::ViewDirection) ? nrOfVertices : 0);
+
+		//calc transform matrix of the instance
+		const Matrix& worldMatrix{ instance.worldMatrix };
+
+		//the positions are unorm against the bounds of the mesh, the dequantization is folded into the position matrices
+		const Matrix& dequantizationMatrix{ m_pMesh->GetDequantizationMatrix() };
+		const Matrix positionWorldMatrix{ dequantizationMatrix * worldMatrix };
+		const Matrix positionWorldViewProjectionMatrix{ dequantizationMatrix * instance.worldViewProjectionMatrix };
+
+		//read the positions of the vertex array as a 16 bit stream
+		constexpr size_t vertexStride{ sizeof(PackedVertex) / sizeof(uint16_t) };
+		const std::span<const uint16_t> positionStream{ reinterpret_cast<const uint16_t*>(vertices.data()) + offsetof(PackedVertex, position) / sizeof(uint16_t), nrOfVertices * vertexStride };
+
+		//batch transform the positions into the structure of arrays scratch buffer
+		instance.transformStreams.resize(nrOfVertices * 7);
+
+		const auto outputStream = [&](size_t stream) { return std::span<float>{ instance.transformStreams.data() + stream * nrOfVertices, nrOfVertices }; };
+
+		const Vector4Streams positions{ outputStream(0), outputStream(1), outputStream(2), outputStream(3) };
+		const Vector3Streams worldPositions{ outputStream(4), outputStream(5), outputStream(6) };
+
+		for (const auto& [first, count] : instance.visibleVertexRanges)
 		{
-			Vector2 v{
-			((vertice.position.x + 1) / 2) * static_cast<float>(m_Width),
-			((1 - vertice.position.y) / 2) * static_cast<float>(m_Height) };
+			const std::span<const uint16_t> rangeStream{ positionStream.subspan(first * vertexStride, count * vertexStride) };
+
+			const Vector4Streams rangePositions{ positions.x.subspan(first, count), positions.y.subspan(first, count), positions.z.subspan(first, count), positions.w.subspan(first, count) };
+
+			//transform vertex with the matrix and do the perspective divide
+			positionWorldViewProjectionMatrix.TransformAndProject(rangeStream, vertexStride, rangePositions, nrOfThreads);
+
+			//the world position is only needed for the view direction
+			if (HasVarying(varyings, Varying::ViewDirection))
+			{
+				positionWorldMatrix.TransformPoints(rangeStream, vertexStride, { worldPositions.x.subspan(first, count), worldPositions.y.subspan(first, count), worldPositions.z.subspan(first, count) }, nrOfThreads);
+			}
+
+			const size_t end{ size_t{ first } + count };
+
+			for (size_t idx{ first }; idx < end; ++idx)
+			{
+				//calc ndc to raster space
+				instance.screenVertices[idx] = Vertex_Screen
+				{
+					Vector2{ ((positions.x[idx] + 1) / 2) * static_cast<float>(m_Width), ((1 - positions.y[idx]) / 2) * static_cast<float>(m_Height) },
+					positions.z[idx],
+					positions.w[idx]
+				};
+			}
+
+			//decode and transform only the varyings the shading mode reads
+			if (HasVarying(varyings, Varying::Normal))
+			{
+				for (size_t idx{ first }; idx < end; ++idx)
+				{
+					instance.normals[idx] = worldMatrix.TransformVector(VertexQuantization::DecodeOctahedral(vertices[idx].normal)).Normalized();
+				}
+			}
+
+			if (HasVarying(varyings, Varying::Tangent))
+			{
+				for (size_t idx{ first }; idx < end; ++idx)
+				{
+					instance.tangents[idx] = worldMatrix.TransformVector(VertexQuantization::DecodeOctahedral(vertices[idx].tangent)).Normalized();
+				}
+			}
+
+			if (HasVarying(varyings, Varying::UV))
+			{
+				for (size_t idx{ first }; idx < end; ++idx)
+				{
+					instance.uvs[idx] = VertexQuantization::DecodeUV(vertices[idx].uv);
+				}
+			}
+
+			if (HasVarying(varyings, Varying::ViewDirection))
+			{
+				for (size_t idx{ first }; idx < end; ++idx)
+				{
+					//calc viewDirection
+					Vector3 viewDirection{ Vector3{ worldPositions.x[idx], worldPositions.y[idx], worldPositions.z[idx] } - m_pCamera->origin };
+					viewDirection.Normalize();
 
-			m_Vertices_ScreenSpace.emplace_back(v);
+					instance.viewDirections[idx] = viewDirection;
+				}
+			}
 		}
 
 	}
 
 	Vector2 Renderer::CalcUVComponent(const float weight, const float invDepth, const size_t& index) const
 	{
-		return (weight * m_pMesh->GetVertices()[index].uv) * invDepth;
+		return (weight * m_pDrawnInstance->uvs[index]) * invDepth;
 	}
 
+	template<MathQuality quality, Texture::AddressMode addressMode>
 	ColorRGB Renderer::CalculateSpecular(const Vector3& sampledNormal, const Vertex_Out& v) const
 	{
 		//get direction of reflection
@@ -478,118 +1430,129 @@ namespace dae {
 		const float reflectionAngle{ Vector3::ClampDot(reflectDirection, -v.viewDirection) };
 
 		//calc phong exponent
-		const float glossExponent{ m_pGlossTexture->Sample(v.uv).r * m_Shinyness };
+		const float glossExponent{ m_pGlossTexture->Sample<addressMode>(v.uv).r * m_Shinyness };
 		//calc phong value
-		const float phong{ powf(reflectionAngle, glossExponent) };
+		float phong{};
+
+		if constexpr (quality == MathQuality::Fast) phong = FastMath::Pow(reflectionAngle, glossExponent);
+		else phong = powf(reflectionAngle, glossExponent);
 	
-		return m_pSpecularTexture->Sample(v.uv) * phong;
+		return m_pSpecularTexture->Sample<addressMode>(v.uv) * phong;
 	}
 
-	void Renderer::InterpolatePixelInfo(Vertex_Out& pixelInfo, const Vertex_Out& v0, const Vertex_Out& v1, const Vertex_Out& v2, const float w0, const float w1, const float w2, const float depth) const
+	template<Varying varyings, MathQuality quality>
+	void Renderer::InterpolatePixelInfo(Vertex_Out& pixelInfo, const Vertex_Out& v0, const Vertex_Out& v1, const Vertex_Out& v2, const Vertex_Screen& s0, const Vertex_Screen& s1, const Vertex_Screen& s2, const float w0, const float w1, const float w2, const float depth) const
 	{
+		//perspective correct weights, one reciprocal per vertex instead of a divide per component
+		constexpr bool isFast{ quality == MathQuality::Fast };
 
-		pixelInfo.normal =
-		{
-
-			((((v0.normal / v0.position.w) * w0) +
-			((v1.normal / v1.position.w) * w1) +
-			((v2.normal / v2.position.w) * w2)) * depth).Normalized()
+		const float weight0{ w0 * (isFast ? FastMath::Reciprocal(s0.w) : 1 / s0.w) };
+		const float weight1{ w1 * (isFast ? FastMath::Reciprocal(s1.w) : 1 / s1.w) };
+		const float weight2{ w2 * (isFast ? FastMath::Reciprocal(s2.w) : 1 / s2.w) };
 
-		};
-		pixelInfo.tangent =
+		if constexpr (HasVarying(varyings, Varying::Normal))
 		{
+			pixelInfo.normal = NormalizeVector<quality>((v0.normal * weight0 + v1.normal * weight1 + v2.normal * weight2) * depth);
+		}
 
-			((((v0.tangent / v0.position.w) * w0) +
-			((v1.tangent / v1.position.w) * w1) +
-			((v2.tangent / v2.position.w) * w2)) * depth).Normalized()
-
-		};
-		pixelInfo.viewDirection =
+		if constexpr (HasVarying(varyings, Varying::Tangent))
 		{
+			pixelInfo.tangent = NormalizeVector<quality>((v0.tangent * weight0 + v1.tangent * weight1 + v2.tangent * weight2) * depth);
+		}
 
-			((((v0.viewDirection / v0.position.w) * w0) +
-			((v1.viewDirection / v1.position.w) * w1) +
-			((v2.viewDirection / v2.position.w) * w2)) * depth).Normalized()
-
-		};
-
+		if constexpr (HasVarying(varyings, Varying::ViewDirection))
+		{
+			pixelInfo.viewDirection = NormalizeVector<quality>((v0.viewDirection * weight0 + v1.viewDirection * weight1 + v2.viewDirection * weight2) * depth);
+		}
 	}
 
-	float Renderer::CalculateInterpolateDepth(const float w0, const float w1, const float w2, const float d0, const float d1, const float d2) const
+	template<MathQuality quality>
+	Vector3 Renderer::NormalizeVector(const Vector3& v) const
 	{
-		return 1 / (w0 * d0 + w1 * d1 + w2 * d2);
+		if constexpr (quality == MathQuality::Fast) return FastMath::Normalized(v);
+		else return v.Normalized();
 	}
 
-	float Renderer::CalculateDepth(const Vertex_Out& v, const bool usingAxisW) const
+	float Renderer::CalculateInterpolateDepth(const float w0, const float w1, const float w2, const float d0, const float d1, const float d2) const
 	{
-		return 1 / v.position[2 + usingAxisW];
+		return 1 / (w0 * d0 + w1 * d1 + w2 * d2);
 	}
 
-	void Renderer::ConvertColorToPixel(ColorRGB& finalColor, const int pixelIndex) const
+	float Renderer::CalculateDepth(const Vertex_Screen& v, const bool usingAxisW) const
 	{
-		finalColor.MaxToOne();
-
-		m_pBackBufferPixels[pixelIndex] = SDL_MapRGB(m_pBackBuffer->format,
-			static_cast<uint8_t>(finalColor.r * 255),
-			static_cast<uint8_t>(finalColor.g * 255),
-			static_cast<uint8_t>(finalColor.b * 255));
+		return 1 / (usingAxisW ? v.w : v.z);
 	}
 
-	bool Renderer::IsOutOfFrustrum(const Vertex_Out& vOut) const
+	bool Renderer::IsOutOfFrustrum(const Vertex_Screen& vScreen) const
 	{
-		return (vOut.position.x < -1 || vOut.position.x > 1) || (vOut.position.y < -1 || vOut.position.y > 1) || (vOut.position.z < 0 || vOut.position.z > 1);
+		//x and y are in raster space, [-1, 1] in ndc is [0, size] here
+		return (vScreen.position.x < 0 || vScreen.position.x > static_cast<float>(m_Width)) || (vScreen.position.y < 0 || vScreen.position.y > static_cast<float>(m_Height)) || (vScreen.z < 0 || vScreen.z > 1);
 	}
 
 	void Renderer::InitializeMesh()
 	{
-		//initialize mesh data & mesh
-
-		std::vector<Vertex> vertices{};
-		std::vector<uint32_t> indices{};
-
-		Utils::ParseOBJ("Resources/vehicle.obj", vertices, indices);
+		//start decoding all textures on worker threads while the meshes are being parsed
+		m_pResourceManager = std::make_unique<ResourceManager>(m_pDevice);
 
-		m_pMesh = std::make_unique<Mesh>(m_pDevice, vertices, indices, EffectType::shaded);
+		m_pResourceManager->RequestTexture("Resources/vehicle_diffuse.png");
+		m_pResourceManager->RequestTexture("Resources/vehicle_normal.png");
+		m_pResourceManager->RequestTexture("Resources/vehicle_specular.png");
+		m_pResourceManager->RequestTexture("Resources/vehicle_gloss.png");
+		m_pResourceManager->RequestTexture("Resources/fireFX_diffuse.png");
 
-		Texture* pTexture{ Texture::LoadFromFile("Resources/vehicle_diffuse.png", m_pDevice) };
-
-		m_pMesh->SetDiffuse(pTexture);
-
-		m_pDiffuseTexture = pTexture;
-
-		//delete pTexture;
-
-		pTexture = Texture::LoadFromFile("Resources/vehicle_normal.png", m_pDevice);
+		//initialize mesh data & mesh
 
-		m_pMesh->SetNormal(pTexture);
-		m_pNormalTexture = pTexture;
+		//the obj files are only parsed when the mesh cache is cold
+		//the vehicle is welded and its triangles reordered for the vertex cache and front to back drawing
+		//the fire is alpha blended, its triangle order is left as authored
+		//the fire loads on a worker while this thread loads the vehicle, the meshes themselves are created here with the device
+		MeshData fireData{};
+		JobCounter fireJob{};
 
-		//delete pTexture;
+		JobSystem::Run(fireJob, [&fireData]() { fireData = MeshCache::Load("Resources/fireFX.obj", false); }, "mesh load");
 
-		pTexture = Texture::LoadFromFile("Resources/vehicle_specular.png", m_pDevice);
+		MeshData vehicleData{ MeshCache::Load("Resources/vehicle.obj", true) };
+		m_MeshStatistics = vehicleData.statistics;
 
-		m_pMesh->SetSpecular(pTexture);
-		m_pSpecularTexture = pTexture;
+		JobSystem::Wait(fireJob);
 
-		//delete pTexture;
+		m_pMesh = std::make_unique<Mesh>(m_pDevice, std::move(vehicleData), EffectType::shaded);
+		m_pFireMesh = std::make_unique<Mesh>(m_pDevice, std::move(fireData), EffectType::transparent);
 
-		pTexture = Texture::LoadFromFile("Resources/vehicle_gloss.png", m_pDevice);
+		//collect the decoded textures, only waits for the ones that are still decoding
+		//the meshes and the software path share the same texture
+		m_pDiffuseTexture = m_pResourceManager->GetTexture("Resources/vehicle_diffuse.png");
+		m_pNormalTexture = m_pResourceManager->GetTexture("Resources/vehicle_normal.png");
+		m_pSpecularTexture = m_pResourceManager->GetTexture("Resources/vehicle_specular.png");
+		m_pGlossTexture = m_pResourceManager->GetTexture("Resources/vehicle_gloss.png");
 
-		m_pMesh->SetGlossiness(pTexture);
-		m_pGlossTexture = pTexture;
+		m_pMesh->SetDiffuse(m_pDiffuseTexture);
+		m_pMesh->SetNormal(m_pNormalTexture);
+		m_pMesh->SetSpecular(m_pSpecularTexture);
+		m_pMesh->SetGlossiness(m_pGlossTexture);
 
-		//delete pTexture;
+		//bake the normal map to object space before it gets compressed, skips the tangent frame per pixel
+		//only the full detail lod, the simplified ones overlap it in uv space
+		const std::span<const uint32_t> fullDetailIndices{ m_pMesh->GetIndices().first(m_pMesh->GetLods()[0].indexCount) };
 
+		m_pObjectSpaceNormalTexture.reset(NormalMapBaker::BakeObjectSpace(*m_pNormalTexture, m_pMesh->GetVertices(), fullDetailIndices, m_ObjectSpaceTriangles));
 
-		Utils::ParseOBJ("Resources/fireFX.obj", vertices, indices);
+		if (m_pObjectSpaceNormalTexture == nullptr) m_ObjectSpaceTriangles.assign(fullDetailIndices.size() / 3, 0);
 
-		m_pFireMesh = std::make_unique<Mesh>(m_pDevice, vertices, indices, EffectType::transparent);
+		//block compress the software copies, every texture only touches its own data so they encode in parallel
+		if (m_CompressSoftwareTextures)
+		{
+			JobCounter compressJobs{};
 
-		pTexture = Texture::LoadFromFile("Resources/fireFX_diffuse.png", m_pDevice);
+			JobSystem::Run(compressJobs, [this]() { m_pDiffuseTexture->Compress(TextureFormat::BC1); }, "texture compress");
+			JobSystem::Run(compressJobs, [this]() { m_pNormalTexture->Compress(TextureFormat::BC5); }, "texture compress");
+			JobSystem::Run(compressJobs, [this]() { m_pSpecularTexture->Compress(TextureFormat::BC1); }, "texture compress");
+			JobSystem::Run(compressJobs, [this]() { m_pGlossTexture->Compress(TextureFormat::BC1); }, "texture compress");
 
-		m_pFireMesh->SetDiffuse(pTexture);
+			JobSystem::Wait(compressJobs);
+		}
 
-		delete pTexture;
+		m_pFireMesh->SetDiffuse(m_pResourceManager->GetTexture("Resources/fireFX_diffuse.png"));
 	}
 
 	HRESULT Renderer::InitializeDirectX()
@@ -3,14 +3,27 @@
 struct SDL_Window;
 struct SDL_Surface;
 
+#include <array>
+#include <atomic>
 #include <memory>
+#include <string_view>
+#include <tuple>
 #include "Camera.h"
 #include "Mesh.h"
+#include "FastMath.h"
+#include "FramePresenter.h"
+#include "JobSystem.h"
+#include "MeshOptimizer.h"
+#include "OcclusionRasterizer.h"
+#include "PixelOutput.h"
+#include "SceneBvh.h"
+#include "Texture.h"
 
 namespace dae
 {
 	//class Mesh;
 	struct Camera;
+	class ResourceManager;
 
 	class Renderer final
 	{
@@ -37,6 +50,7 @@ namespace dae
 			std::cout << "\t[F9]  Cycle CullMode (BACK / FRONT / NONE)\n";
 			std::cout << "\t[F10] Toggle Uniform ClearColor (ON / OFF)\n";
 			std::cout << "\t[F11] Toggle Print FPS (ON / OFF)\n";
+			std::cout << "\t[L]   Toggle Automatic LOD (ON / OFF)\n";
 			std::cout << "\n\t[ESC] Toggle Mouse lock (ON / OFF)\n";
 			std::cout << "\t[ENTER] Refresh console\n";
 			std::cout << "\n";
@@ -51,6 +65,12 @@ namespace dae
 			std::cout << "\t[F6] Toggle NormalMap (ON / OFF)\n";
 			std::cout << "\t[F7] Toggle DepthBuffer Visualization (ON / OFF)\n";
 			std::cout << "\t[F8] Toggle BoundingBox Visualization (ON / OFF)\n";
+			std::cout << "\t[F12] Toggle Math Quality (FAST / EXACT)\n";
+			std::cout << "\t[I]   Cycle Instance Grid (1 / 100 / 1024)\n";
+			std::cout << "\t[O]   Toggle Occlusion Culling (ON / OFF)\n";
+			std::cout << "\t[P]   Toggle Frame Pipeline (LATENCY / THROUGHPUT)\n";
+			std::cout << "\t[B]   Toggle Back Buffers (DOUBLE / TRIPLE)\n";
+			std::cout << "\t[M]   Toggle Present Mode (FIFO / LATEST)\n";
 			std::cout << "\n\n";
 		}
 
@@ -191,6 +211,114 @@ namespace dae
 			}
 		}
 
+		void ToggleAutomaticLod()
+		{
+			m_IsAutomaticLod = !m_IsAutomaticLod;
+
+			//back to full detail, Update keeps it there while the selection is off
+			if (!m_IsAutomaticLod) m_pMesh->SetLodIndex(0);
+
+			std::cout << "\033[33m"; // TEXT COLOR
+			std::cout << "**(SHARED) Automatic LOD ";
+			if (m_IsAutomaticLod)
+			{
+				std::cout << "ON\n";
+			}
+			else
+			{
+				std::cout << "OFF\n";
+			}
+		}
+
+		//instances drawn by the software rasterizer, placed after the rotation of the vehicle
+		void AddInstance(const Matrix& worldMatrix, const ColorRGB& tint = colors::White)
+		{
+			m_Instances.push_back(MeshInstance{ worldMatrix, tint });
+			m_IsInstanceBvhStale = true;
+		}
+
+		//moves an instance, the bvh is refit instead of rebuilt
+		void SetInstanceWorldMatrix(size_t instanceIndex, const Matrix& worldMatrix)
+		{
+			m_Instances[instanceIndex].worldMatrix = worldMatrix;
+			m_AreInstanceBoxesStale = true;
+		}
+
+		void ClearInstances()
+		{
+			m_Instances.clear();
+			m_IsInstanceBvhStale = true;
+		}
+
+		//replaces the instances with a grid of vehicles around the place of the vehicle
+		void CycleInstanceGrid();
+
+		void ToggleOcclusionCulling()
+		{
+			m_IsOcclusionCulling = !m_IsOcclusionCulling;
+
+			std::cout << "\033[35m"; // TEXT COLOR
+			std::cout << "**(SOFTWARE) Occlusion Culling ";
+			if (m_IsOcclusionCulling)
+			{
+				std::cout << "ON\n";
+			}
+			else
+			{
+				std::cout << "OFF\n";
+			}
+		}
+
+		void ToggleFrameMode()
+		{
+			m_FrameMode = m_FrameMode == FrameMode::Latency ? FrameMode::Throughput : FrameMode::Latency;
+
+			std::cout << "\033[35m"; // TEXT COLOR
+			std::cout << "**(SOFTWARE) Frame Pipeline ";
+			if (m_FrameMode == FrameMode::Latency)
+			{
+				std::cout << "LATENCY\n";
+			}
+			else
+			{
+				std::cout << "THROUGHPUT\n";
+			}
+		}
+
+		void ToggleBackBuffers()
+		{
+			m_pPresenter->SetNrOfBackBuffers(m_pPresenter->GetNrOfBackBuffers() == 2 ? 3 : 2);
+
+			std::cout << "\033[35m"; // TEXT COLOR
+			std::cout << "**(SOFTWARE) Back Buffers ";
+			if (m_pPresenter->GetNrOfBackBuffers() == 2)
+			{
+				std::cout << "DOUBLE\n";
+			}
+			else
+			{
+				std::cout << "TRIPLE\n";
+			}
+		}
+
+		void TogglePresentMode()
+		{
+			const bool isFifo{ m_pPresenter->GetPresentMode() == FramePresenter::PresentMode::Fifo };
+
+			m_pPresenter->SetPresentMode(isFifo ? FramePresenter::PresentMode::Latest : FramePresenter::PresentMode::Fifo);
+
+			std::cout << "\033[35m"; // TEXT COLOR
+			std::cout << "**(SOFTWARE) Present Mode ";
+			if (isFifo)
+			{
+				std::cout << "LATEST\n";
+			}
+			else
+			{
+				std::cout << "FIFO\n";
+			}
+		}
+
 		void ToggleUniform()
 		{
 			m_IsUniform = !m_IsUniform;
@@ -246,6 +374,26 @@ namespace dae
 			}
 		}
 
+		void ToggleMathQuality()
+		{
+			if (m_CurrentRasterizerState != RasterizerState::software) return;
+
+			m_MathQuality = m_MathQuality == MathQuality::Fast ? MathQuality::Exact : MathQuality::Fast;
+
+			std::cout << "\033[35m"; // TEXT COLOR
+			std::cout << "**(SOFTWARE) Math Quality ";
+			if (m_MathQuality == MathQuality::Fast)
+			{
+				std::cout << "FAST\n";
+			}
+			else
+			{
+				std::cout << "EXACT\n";
+			}
+
+			CompareMathQuality();
+		}
+
 		void TogglePrintingFPS()
 		{
 			m_CanPrint = !m_CanPrint;
@@ -253,6 +401,9 @@ namespace dae
 
 		bool CanPrintFPS() const { return m_CanPrint; }
 
+		//clusters submitted and culled in the last software frame, time spent in the jobs of every stage since the last call
+		void PrintFrameStatistics();
+
 	private:
 
 		SDL_Window* m_pWindow{};
@@ -268,6 +419,15 @@ namespace dae
 
 		float m_RotationSpeed{ 45 * TO_RADIANS };
 
+		//lod of the vehicle picked from its projected error
+		bool m_IsAutomaticLod{ true };
+
+		static constexpr float m_LodPixelError{ 1.f };
+		static constexpr float m_LodHysteresis{ 0.25f };
+
+		//pixels one unit covers at distance 1, fov holds the tangent of half the vertical angle
+		float GetPixelsPerUnit() const { return static_cast<float>(m_Height) / (2.f * m_pCamera->fov); }
+
 		bool m_CanShowFire{ true };
 
 		bool m_CanPrint{ false };
@@ -317,33 +477,63 @@ namespace dae
 		static constexpr int m_RasterizerStateSize{ static_cast<int>(RasterizerState::uniform) + 1 };
 
 
-		const ColorRGB m_ColorsState[m_RasterizerStateSize]{  { 0.39f, 0.59f, .93f } , { 0.39f, 0.39f, .39f }, { 0.1f, 0.1f, .1f } };
+		static constexpr ColorRGB m_ColorsState[m_RasterizerStateSize]{  { 0.39f, 0.59f, .93f } , { 0.39f, 0.39f, .39f }, { 0.1f, 0.1f, .1f } };
 
 #pragma region software_code
 
-		//buffers for software
-		SDL_Surface* m_pFrontBuffer{ nullptr };
+		//buffers for software, the back buffer is the one of the presenter the current frame is drawn into
+		std::unique_ptr<FramePresenter> m_pPresenter{};
 		SDL_Surface* m_pBackBuffer{ nullptr };
 		uint32_t* m_pBackBufferPixels{};
+		PixelPacker m_PixelPacker{};
+
+		enum class FrameMode
+		{
+			//every frame is on screen before the next one starts, only the batches of a frame overlap
+			Latency,
+			//the culling and vertex stage of a frame run on the workers while the frame of the last Render is rasterized
+			//frames reach the window one Render later, frames with more visible instances than a set of slots are drawn right away
+			Throughput
+		};
+
+		FrameMode m_FrameMode{ FrameMode::Throughput };
+
+		void AcquireBackBuffer();
+
+		//unlocks the back buffer and queues it on the presenter
+		void PresentBackBuffer();
 
 		float* m_pDepthBufferPixels{};
 
 		int m_NrOfPixels;
 
 		//textures
-		Texture* m_pDiffuseTexture{};
-		Texture* m_pNormalTexture{};
-		Texture* m_pSpecularTexture{};
-		Texture* m_pGlossTexture{};
+		std::unique_ptr<ResourceManager> m_pResourceManager{};
+
+		std::shared_ptr<Texture> m_pDiffuseTexture{};
+		std::shared_ptr<Texture> m_pNormalTexture{};
+		std::shared_ptr<Texture> m_pSpecularTexture{};
+		std::shared_ptr<Texture> m_pGlossTexture{};
+
+		//normal map baked to object space (RGBA8, sampled without renormalizing)
+		//triangles sharing uv space with another triangle keep the tangent space map
+		std::shared_ptr<Texture> m_pObjectSpaceNormalTexture{};
+		std::vector<uint8_t> m_ObjectSpaceTriangles{};
+
+		//vertex welding and triangle reordering done at load
+		MeshOptimizer::Statistics m_MeshStatistics{};
+
+		//store the software textures block compressed (BC1 color, BC5 normals) to shrink the working set
+		static constexpr bool m_CompressSoftwareTextures{ true };
 
 		//light data
-		const Vector3 m_LightDir{ 0.577f, -0.577f , 0.577f };
-		const float m_LightIntensity{ 7.f };
+		static constexpr Vector3 m_LightDir{ 0.577f, -0.577f , 0.577f };
+		static constexpr float m_LightIntensity{ 7.f };
 
-		const float m_KD{ 1.f };
-		const float m_Shinyness{ 25 };
+		static constexpr float m_KD{ 1.f };
+		static constexpr float m_Shinyness{ 25 };
 
-		const ColorRGB m_AmbientColor{ 0.025f, 0.025f, 0.025f };
+		static constexpr ColorRGB m_AmbientColor{ 0.025f, 0.025f, 0.025f };
 
 		float m_AspectRatio;
 
@@ -354,12 +544,158 @@ namespace dae
 
 		bool m_ShowNormal{ true };
 
+		//approximate pow, rsqrt and reciprocals in the pixel loop
+		MathQuality m_MathQuality{ MathQuality::Fast };
+
+		//sampler state of the software draws, every texture of a draw is addressed the same way like with the samplers of the effects
+		Texture::AddressMode m_AddressMode{ Texture::AddressMode::Wrap };
+
+		//max difference per color channel (0-255) allowed between the exact and the fast frame
+		static constexpr int m_MathQualityErrorBound{ 2 };
+
+
+		static constexpr float m_BoundingMargin{ 1.f };
+
+		struct ClusterStatistics
+		{
+			uint32_t submitted{};
+			uint32_t frustumCulled{};
+			uint32_t backfaceCulled{};
+			uint32_t occluded{};
+		};
+
+		//one visible instance after the vertex stage
+		//there are two sets of one per worker, a batch of instances is transformed into one set while the other one is rasterized
+		struct TransformedInstance
+		{
+			Matrix worldMatrix{};
+			Matrix worldViewProjectionMatrix{};
+			ColorRGB tint{};
+			uint32_t lodIndex{};
+
+			std::vector<Vertex_Screen> screenVertices{};
+
+			//varyings of the transformed vertices, one array per varying
+			//only the ones the shading mode reads are filled, the others stay empty
+			std::vector<Vector3> normals{};
+			std::vector<Vector3> tangents{};
+			std::vector<Vector2> uvs{};
+			std::vector<Vector3> viewDirections{};
+
+			//structure of arrays scratch for the batch vertex transform (projected xyzw, world position)
+			std::vector<float> transformStreams{};
+
+			//meshlets that survived the cluster culling and the vertex ranges they own (first, count), neighbours merged
+			std::vector<uint32_t> visibleMeshlets{};
+			std::vector<std::pair<uint32_t, uint32_t>> visibleVertexRanges{};
+
+			ClusterStatistics clusterStatistics{};
+		};
+
+		//instances of the vehicle, the first one is the vehicle itself
+		std::vector<MeshInstance> m_Instances{ MeshInstance{} };
+		std::vector<uint32_t> m_VisibleInstances{};
+
+		//the buffers grow to the largest lod once and are reused every frame
+		std::vector<TransformedInstance> m_TransformedInstances{};
+
+		//instance RenderTriangle and PixelShading read from
+		const TransformedInstance* m_pDrawnInstance{};
+
+		//a triangle of the drawn instance, with the arguments of RenderTriangle
+		struct BinnedTriangle
+		{
+			size_t index{};
+			bool swapVertices{};
+			bool objectSpaceNormal{};
+		};
+
+		//the triangles of every band of rows per binning part, [part * nrOfBands + band], reused for every instance
+		std::vector<std::vector<BinnedTriangle>> m_BandTriangles{};
+
+		//bvh over the world boxes of the instances, rebuilt when instances are added or removed
+		//and refit when the vehicle rotates or an instance moves
+		SceneBvh m_InstanceBvh{};
+		std::vector<BoundingBox> m_InstanceBoxes{};
+		bool m_IsInstanceBvhStale{ true };
+		bool m_AreInstanceBoxesStale{ true };
+		uint32_t m_InstanceBvhWorldVersion{};
+
+		//max depth of every tile of the last software frame and the view projection it was rendered with
+		//boxes are tested against the depth of the previous frame, an object coming out from behind an occluder is drawn a frame late
+		bool m_IsOcclusionCulling{ true };
+		bool m_HasOcclusionDepth{ false };
+
+		static constexpr int m_OcclusionTileSize{ 8 };
+
+		int m_OcclusionWidth{};
+		int m_OcclusionHeight{};
+		std::vector<float> m_OcclusionDepth{};
+		Matrix m_OcclusionViewProjectionMatrix{};
 
-		const float m_BoundingMargin{ 1.f };
+		//the nearest large instances are drawn depth only at low resolution before the vertex stage,
+		//the other instances and the meshlets are tested against them in the same frame
+		OcclusionRasterizer m_OcclusionRasterizer{};
+		std::vector<float> m_OccluderStreams{};
 
-		std::vector<Vector2> m_Vertices_ScreenSpace{};
+		static constexpr uint32_t m_MaxNrOfOccluders{ 8 };
 
-		std::vector<Vertex_Out> m_Vertices_Out{};
+		//radius of the box over its distance, about a tenth of the screen height
+		static constexpr float m_MinOccluderSize{ 0.1f };
+
+		struct InstanceStatistics
+		{
+			uint32_t submitted{};
+			uint32_t frustumCulled{};
+			uint32_t occluded{};
+			uint32_t occluders{};
+			uint32_t occluderCulled{};
+		};
+
+		InstanceStatistics m_InstanceStatistics{};
+		ClusterStatistics m_ClusterStatistics{};
+
+		//the geometry of a throughput frame, rasterized in the next Render
+		struct PendingFrame
+		{
+			bool isValid{};
+			Varying varyings{};
+			size_t firstSlot{};
+			size_t nrOfInstances{};
+
+			//the camera the geometry job transformed it with
+			Matrix viewProjectionMatrix{};
+
+			//the culling of its own Render, printed when it is drawn
+			InstanceStatistics instanceStatistics{};
+		};
+
+		PendingFrame m_PendingFrame{};
+
+		//time of the jobs by name, filled by the timing hook of the job system
+		//every thread adds to its own table, so the jobs never wait on each other, PrintFrameStatistics merges the tables by name
+		struct StageTiming
+		{
+			std::atomic<const char*> pName{};
+			std::atomic<uint32_t> nrOfJobs{};
+			std::atomic<int64_t> nanoseconds{};
+		};
+
+		//the names of a thread are only added by that thread, thread 0 is the main thread, the only one outside of the workers that runs jobs
+		struct alignas(64) ThreadStageTimings
+		{
+			static constexpr uint32_t m_MaxStages{ 16 };
+
+			std::array<StageTiming, m_MaxStages> stages{};
+			std::atomic<uint32_t> nrOfStages{};
+		};
+
+		//static, the hook can still run on a worker that loaded it right before the renderer removed it
+		static std::vector<ThreadStageTimings> m_StageTimings;
+
+		static void AddStageTiming(const JobTiming& timing);
+
+		uint32_t m_InstanceGridIndex{};
 
 		enum class SoftwareModes
 		{
@@ -376,23 +712,90 @@ namespace dae
 
 		bool CheckValidCullCrosses(const float edge01, const float edge02, const float edge03) const;
 
-		void VertexTransformationFunction();
+		//varyings read by the current shading mode
+		Varying GetActiveVaryings() const;
+
+		//RenderTriangle instantiated for a varying set, math quality and address mode
+		//only the rows [firstRow, endRow) are written
+		using RenderTriangleFunction = void (Renderer::*)(const size_t&, const bool, const bool, const int, const int) const;
+
+		//rebuilds or refits the instance bvh when the instances or the vehicle moved
+		void UpdateInstanceBvh();
+
+		//queries the bvh for the instances inside the frustum and not occluded, picks their lod and sorts them front to back
+		void CullInstances();
+
+		//draws the occluders into the occlusion rasterizer and drops the visible instances behind them
+		void RenderOccluders();
+
+		//keeps the max depth of every tile of the depth buffer for the occlusion test of the next frame
+		//viewProjectionMatrix is the camera the depth buffer was drawn with
+		void BuildOcclusionDepth(const Matrix& viewProjectionMatrix);
+
+		//true when the nearest point of the box is behind the depth of every tile it covers in the previous frame
+		bool IsOccluded(const BoundingBox& box) const;
+
+		//rejects whole meshlets against the frustum and by their normal cone, before any vertex is transformed
+		void CullMeshlets(TransformedInstance& instance) const;
+
+		//only transforms the vertices of the visible meshlets
+		//writes nothing but the instance, so the instances of a batch can be transformed on their own threads
+		void VertexTransformationFunction(TransformedInstance& instance, Varying varyings, unsigned int nrOfThreads) const;
+
+		//rasterizes the triangles of the lod or the visible meshlets of the drawn instance, split into bands of rows over the threads
+		void RasterizeInstance(RenderTriangleFunction pRenderTriangle);
+
+		//triangle list at lod 0 with meshlets, binned per visible meshlet instead of per triangle
+		bool IsDrawnByMeshlets() const;
+		size_t GetNrOfBinItems() const;
+
+		//sorts the triangles of the items [firstItem, endItem) into the bands of rows they touch, in order
+		void BinTriangles(size_t firstItem, size_t endItem, int bandHeight, std::span<std::vector<BinnedTriangle>> bands) const;
+		void BinTriangle(size_t index, bool swapVertices, bool objectSpaceNormal, int bandHeight, std::span<std::vector<BinnedTriangle>> bands) const;
+
+		//clears the buffers and rasterizes the mesh into the locked back buffer
+		void RasterizeSoftware();
+
+		//throughput frame: rasterizes and presents the pending frame while the geometry of this one is made on the workers
+		void RasterizeSoftwarePipelined();
+
+		//instance culling and the occluders, fills m_VisibleInstances
+		void CullFrame();
+
+		//meshlet culling and vertex stage of one instance into a slot
+		void TransformInstance(TransformedInstance& instance, const MeshInstance& meshInstance, Varying varyings, unsigned int nrOfThreads) const;
+
+		//transforms and rasterizes the visible instances in batches, the vertex stage of the next batch overlaps the raster of this one
+		void RasterizeVisibleInstances(Varying varyings);
+
+		void RasterizeTransformedInstance(const TransformedInstance& instance, RenderTriangleFunction pRenderTriangle);
+
+		//renders the current frame with both math qualities and prints the difference
+		void CompareMathQuality();
+
+		//the math quality and the address mode are resolved once per frame by the RenderTriangle instantiation, the pixel functions take them as template parameters
+		template<MathQuality quality>
+		Vector3 NormalizeVector(const Vector3& v) const;
 
 		Vector2 CalcUVComponent(const float weight, const float invDepth, const size_t& index) const;
 
+		template<MathQuality quality, Texture::AddressMode addressMode>
 		ColorRGB CalculateSpecular(const Vector3& sampledNormal, const Vertex_Out& v) const;
 
-		void InterpolatePixelInfo(Vertex_Out& pixelInfo, const Vertex_Out& v0, const Vertex_Out& v1, const Vertex_Out& v2, const float w0, const float w1, const float w2, const float depth) const;
+		template<Varying varyings, MathQuality quality>
+		void InterpolatePixelInfo(Vertex_Out& pixelInfo, const Vertex_Out& v0, const Vertex_Out& v1, const Vertex_Out& v2, const Vertex_Screen& s0, const Vertex_Screen& s1, const Vertex_Screen& s2, const float w0, const float w1, const float w2, const float depth) const;
 
 		float CalculateInterpolateDepth(const float w0, const float w1, const float w2, const float d0, const float d1, const float d2) const;
 
-		float CalculateDepth(const Vertex_Out& v, const bool usingAxisW) const;
+		float CalculateDepth(const Vertex_Screen& v, const bool usingAxisW) const;
 
-		void ConvertColorToPixel(ColorRGB& finalColor, const int pixelIndex) const;
+		template<Varying varyings, MathQuality quality, Texture::AddressMode addressMode>
+		void RenderTriangle(const size_t& index, const bool swapVertices, const bool objectSpaceNormal, const int firstRow, const int endRow) const;
 
-		void RenderTriangle(const size_t& index, const bool swapVertices) const;
+		static RenderTriangleFunction GetRenderTriangleFunction(Varying varyings, MathQuality quality, Texture::AddressMode addressMode);
 
-		void PixelShading(const Vertex_Out& vOut, ColorRGB& finalColor) const;
+		template<MathQuality quality, Texture::AddressMode addressMode>
+		void PixelShading(const Vertex_Out& vOut, ColorRGB& finalColor, const bool objectSpaceNormal) const;
 
 		void ClearBackGround() const
 		{
@@ -410,7 +813,7 @@ namespace dae
 			std::fill_n(m_pDepthBufferPixels, m_NrOfPixels, FLT_MAX);
 		}
 
-		bool IsOutOfFrustrum(const Vertex_Out& vOut) const;
+		bool IsOutOfFrustrum(const Vertex_Screen& vScreen) const;
 
 
 #pragma endregion
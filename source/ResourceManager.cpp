@@ -0,0 +1,93 @@
+#include "pch.h"
+#include "ResourceManager.h"
+#include "Texture.h"
+
+namespace dae
+{
+	ResourceManager::ResourceManager(ID3D11Device* pDevice, size_t memoryBudget)
+		: m_pDevice{ pDevice },
+		  m_MemoryBudget{ memoryBudget }
+	{
+	}
+
+	void ResourceManager::RequestTexture(const std::string& path)
+	{
+		if (m_Textures.contains(path)) return;
+
+		m_TextureLoader.Request(path);
+	}
+
+	std::shared_ptr<Texture> ResourceManager::GetTexture(const std::string& path)
+	{
+		//already resident, hand out another reference
+		if (const auto it{ m_Textures.find(path) }; it != m_Textures.end())
+		{
+			it->second.lastUse = ++m_UseCounter;
+			return it->second.pTexture;
+		}
+
+		std::shared_ptr<Texture> pTexture{ m_TextureLoader.Get(path, m_pDevice) };
+
+		m_Textures.emplace(path, TextureEntry{ pTexture, ++m_UseCounter });
+
+		Trim();
+
+		return pTexture;
+	}
+
+	void ResourceManager::SetMemoryBudget(size_t memoryBudget)
+	{
+		m_MemoryBudget = memoryBudget;
+
+		Trim();
+	}
+
+	size_t ResourceManager::GetResidentBytes(const std::string& path) const
+	{
+		const auto it{ m_Textures.find(path) };
+
+		if (it == m_Textures.end()) return 0;
+
+		return it->second.pTexture->GetMemorySize() + it->second.pTexture->GetGPUMemorySize();
+	}
+
+	size_t ResourceManager::GetResidentBytes() const
+	{
+		size_t residentBytes{};
+
+		for (const auto& [path, entry] : m_Textures)
+		{
+			residentBytes += entry.pTexture->GetMemorySize() + entry.pTexture->GetGPUMemorySize();
+		}
+
+		return residentBytes;
+	}
+
+	void ResourceManager::Trim()
+	{
+		size_t residentBytes{ GetResidentBytes() };
+
+		while (residentBytes > m_MemoryBudget)
+		{
+			//find the least recently used texture that is only referenced by the cache
+			auto oldest{ m_Textures.end() };
+
+			for (auto it{ m_Textures.begin() }; it != m_Textures.end(); ++it)
+			{
+				if (it->second.pTexture.use_count() > 1) continue;
+
+				if (oldest == m_Textures.end() || it->second.lastUse < oldest->second.lastUse)
+				{
+					oldest = it;
+				}
+			}
+
+			//everything left is still in use
+			if (oldest == m_Textures.end()) return;
+
+			residentBytes -= oldest->second.pTexture->GetMemorySize() + oldest->second.pTexture->GetGPUMemorySize();
+
+			m_Textures.erase(oldest);
+		}
+	}
+}
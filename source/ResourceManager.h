@@ -0,0 +1,63 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include "TextureLoader.h"
+
+namespace dae
+{
+	class Texture;
+
+	//hands out shared textures keyed by path, every file is loaded once no matter how many meshes use it
+	//textures nobody holds anymore stay cached until the resident memory goes over the budget
+	class ResourceManager final
+	{
+	public:
+
+		explicit ResourceManager(ID3D11Device* pDevice, size_t memoryBudget = m_DefaultMemoryBudget);
+		~ResourceManager() = default;
+
+		ResourceManager(const ResourceManager&) = delete;
+		ResourceManager(ResourceManager&&) noexcept = delete;
+		ResourceManager& operator=(const ResourceManager&) = delete;
+		ResourceManager& operator=(ResourceManager&&) noexcept = delete;
+
+		//starts decoding the texture in the background when it is not resident yet
+		void RequestTexture(const std::string& path);
+
+		//returns the shared texture, loads it (or waits for the pending request) on the first call
+		std::shared_ptr<Texture> GetTexture(const std::string& path);
+
+		void SetMemoryBudget(size_t memoryBudget);
+		size_t GetMemoryBudget() const { return m_MemoryBudget; }
+
+		//bytes of one texture (software copy + D3D texture), 0 when it is not resident
+		size_t GetResidentBytes(const std::string& path) const;
+
+		//bytes of all resident textures
+		size_t GetResidentBytes() const;
+
+		//evicts the least recently used textures that nobody holds until the budget is met
+		void Trim();
+
+	private:
+
+		struct TextureEntry
+		{
+			std::shared_ptr<Texture> pTexture{};
+			uint64_t lastUse{};
+		};
+
+		static constexpr size_t m_DefaultMemoryBudget{ 256 * 1024 * 1024 };
+
+		ID3D11Device* m_pDevice{};
+
+		size_t m_MemoryBudget{};
+
+		uint64_t m_UseCounter{};
+
+		std::unordered_map<std::string, TextureEntry> m_Textures{};
+
+		TextureLoader m_TextureLoader{};
+	};
+}
@@ -5,6 +5,10 @@ float4x4 gWorldViewProj : WorldViewProjection;
 float4x4 gWorldMatrix : WorldMatrix;
 float4x4 gInverseViewMatrix : InverseViewMatrix;
 
+//box the positions are quantized against
+float3 gPositionMin : PositionMin;
+float3 gPositionExtent : PositionExtent;
+
 Texture2D gDiffuseMap : DiffuseMap;
 
 //SamplerState
@@ -62,11 +66,12 @@ DepthStencilState gDepthStencilState
 //-------------------------
 //	Input/Output Structs
 //-------------------------
+//quantized vertex: unorm position, octahedral normal and tangent, half precision uv
 struct VS_INPUT
 {
-	float3 Position : POSITION;
-	float3 Normal : NORMAL;
-	float3 Tangent : TANGENT;
+	float4 Position : POSITION;
+	float2 Normal : NORMAL;
+	float2 Tangent : TANGENT;
 	float2 uv : TEXCOORD;
 };
 
@@ -79,15 +84,35 @@ struct VS_OUTPUT
 	float2 uv : TEXCOORD;
 };
 
+//-------------------------
+//	Vertex Decoding
+//-------------------------
+float3 DecodePosition(float4 position)
+{
+	return gPositionMin + position.xyz * gPositionExtent;
+}
+
+float3 DecodeOctahedral(float2 encoded)
+{
+	float3 direction = float3(encoded, 1.f - abs(encoded.x) - abs(encoded.y));
+
+	//unfold the lower hemisphere
+	const float fold = saturate(-direction.z);
+	direction.xy += direction.xy >= 0.f ? -fold : fold;
+
+	return normalize(direction);
+}
+
 //-------------------------
 //	Vertex Shader
 //-------------------------
 VS_OUTPUT VS(VS_INPUT input)
 {
 	VS_OUTPUT output = (VS_OUTPUT)0;
-	output.Position = mul(float4(input.Position, 1.f), gWorldViewProj);
-	output.WorldPosition = mul(float4(input.Position, 1.f), gWorldMatrix);
-	output.Normal = mul(normalize(input.Normal), (float3x3)gWorldViewProj);
+	const float3 position = DecodePosition(input.Position);
+	output.Position = mul(float4(position, 1.f), gWorldViewProj);
+	output.WorldPosition = mul(float4(position, 1.f), gWorldMatrix);
+	output.Normal = mul(DecodeOctahedral(input.Normal), (float3x3)gWorldViewProj);
 	output.uv = input.uv;
 	return output;
 }
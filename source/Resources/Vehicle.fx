@@ -13,6 +13,10 @@ float4x4 gWorldViewProj : WorldViewProjection;
 float4x4 gWorldMatrix : WorldMatrix;
 float4x4 gInverseViewMatrix : InverseViewMatrix;
 
+//box the positions are quantized against
+float3 gPositionMin : PositionMin;
+float3 gPositionExtent : PositionExtent;
+
 Texture2D gDiffuseMap : DiffuseMap;
 Texture2D gNormalMap : NormalMap;
 Texture2D gSpecularMap : SpecularMap;
@@ -69,11 +73,12 @@ DepthStencilState gDepthStencilState
 //-------------------------
 //	Input/Output Structs
 //-------------------------
+//quantized vertex: unorm position, octahedral normal and tangent, half precision uv
 struct VS_INPUT
 {
-	float3 Position : POSITION;
-	float3 Normal : NORMAL;
-	float3 Tangent : TANGENT;
+	float4 Position : POSITION;
+	float2 Normal : NORMAL;
+	float2 Tangent : TANGENT;
 	float2 UV : TEXCOORD;
 };
 
@@ -134,16 +139,36 @@ float3 PixelShading(VS_OUTPUT input)
 	return finalColor + gAmbientColor;
 }
 
+//-------------------------
+//	Vertex Decoding
+//-------------------------
+float3 DecodePosition(float4 position)
+{
+	return gPositionMin + position.xyz * gPositionExtent;
+}
+
+float3 DecodeOctahedral(float2 encoded)
+{
+	float3 direction = float3(encoded, 1.f - abs(encoded.x) - abs(encoded.y));
+
+	//unfold the lower hemisphere
+	const float fold = saturate(-direction.z);
+	direction.xy += direction.xy >= 0.f ? -fold : fold;
+
+	return normalize(direction);
+}
+
 //-------------------------
 //	Vertex Shader
 //-------------------------
 VS_OUTPUT VS(VS_INPUT input)
 {
 	VS_OUTPUT output;
-	output.Position = mul(float4(input.Position, 1.f), gWorldViewProj);
-	output.WorldPosition = mul(float4(input.Position, 1.0f), gWorldMatrix);
-	output.Tangent = mul(normalize(input.Tangent), (float3x3)gWorldMatrix);
-	output.Normal = mul(normalize(input.Normal), (float3x3)gWorldMatrix);
+	const float3 position = DecodePosition(input.Position);
+	output.Position = mul(float4(position, 1.f), gWorldViewProj);
+	output.WorldPosition = mul(float4(position, 1.0f), gWorldMatrix);
+	output.Tangent = mul(DecodeOctahedral(input.Tangent), (float3x3)gWorldMatrix);
+	output.Normal = mul(DecodeOctahedral(input.Normal), (float3x3)gWorldMatrix);
 	output.UV = input.UV;
 	return output;
 }
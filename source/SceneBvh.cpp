@@ -0,0 +1,110 @@
+#include "pch.h"
+#include "SceneBvh.h"
+#include <numeric>
+
+namespace dae
+{
+	BoundingBox BoundingBox::Transform(const Vector3& min, const Vector3& max, const Matrix& m)
+	{
+		const Vector3 center{ m.TransformPoint((min + max) * 0.5f) };
+		const Vector3 halfExtent{ (max - min) * 0.5f };
+
+		//every axis of the new box is the sum of the projections of the rotated half extents
+		Vector3 newHalfExtent{};
+
+		for (int column{}; column < 3; ++column)
+		{
+			newHalfExtent[column] =
+				std::abs(m[0][column]) * halfExtent.x +
+				std::abs(m[1][column]) * halfExtent.y +
+				std::abs(m[2][column]) * halfExtent.z;
+		}
+
+		return BoundingBox{ center - newHalfExtent, center + newHalfExtent };
+	}
+
+	void SceneBvh::Build(std::span<const BoundingBox> boxes)
+	{
+		m_Boxes.assign(boxes.begin(), boxes.end());
+
+		m_Objects.resize(boxes.size());
+		std::iota(m_Objects.begin(), m_Objects.end(), 0);
+
+		m_Nodes.clear();
+
+		if (boxes.empty()) return;
+
+		//a binary tree with leaves of at least one object never needs more nodes than this
+		m_Nodes.reserve(boxes.size() * 2);
+		m_Nodes.push_back(Node{ {}, 0, static_cast<uint32_t>(boxes.size()), 0 });
+
+		Split(0);
+	}
+
+	void SceneBvh::Split(uint32_t nodeIndex)
+	{
+		const uint32_t firstObject{ m_Nodes[nodeIndex].firstObject };
+		const uint32_t nrOfObjects{ m_Nodes[nodeIndex].nrOfObjects };
+
+		const auto begin{ m_Objects.begin() + firstObject };
+		const auto end{ begin + nrOfObjects };
+
+		BoundingBox box{ m_Boxes[*begin] };
+		BoundingBox centers{ box.GetCenter(), box.GetCenter() };
+
+		for (auto it{ begin }; it != end; ++it)
+		{
+			box = BoundingBox::Union(box, m_Boxes[*it]);
+
+			const Vector3 center{ m_Boxes[*it].GetCenter() };
+			centers = BoundingBox::Union(centers, BoundingBox{ center, center });
+		}
+
+		m_Nodes[nodeIndex].box = box;
+
+		if (nrOfObjects <= m_MaxLeafSize) return;
+
+		//split the centers on their longest axis
+		const Vector3 size{ centers.max - centers.min };
+		const int axis{ size.x >= size.y && size.x >= size.z ? 0 : (size.y >= size.z ? 1 : 2) };
+
+		const auto middle{ begin + nrOfObjects / 2 };
+
+		std::nth_element(begin, middle, end, [&](uint32_t a, uint32_t b) { return m_Boxes[a].GetCenter()[axis] < m_Boxes[b].GetCenter()[axis]; });
+
+		const uint32_t leftChild{ static_cast<uint32_t>(m_Nodes.size()) };
+		const uint32_t nrOfLeft{ nrOfObjects / 2 };
+
+		m_Nodes[nodeIndex].leftChild = leftChild;
+
+		m_Nodes.push_back(Node{ {}, firstObject, nrOfLeft, 0 });
+		m_Nodes.push_back(Node{ {}, firstObject + nrOfLeft, nrOfObjects - nrOfLeft, 0 });
+
+		Split(leftChild);
+		Split(leftChild + 1);
+	}
+
+	void SceneBvh::Refit(std::span<const BoundingBox> boxes)
+	{
+		m_Boxes.assign(boxes.begin(), boxes.end());
+
+		//children come after their parents, so walking backwards visits them first
+		for (size_t nodeIndex{ m_Nodes.size() }; nodeIndex-- > 0;)
+		{
+			Node& node{ m_Nodes[nodeIndex] };
+
+			if (node.leftChild != 0)
+			{
+				node.box = BoundingBox::Union(m_Nodes[node.leftChild].box, m_Nodes[node.leftChild + 1].box);
+				continue;
+			}
+
+			node.box = m_Boxes[m_Objects[node.firstObject]];
+
+			for (uint32_t idx{ node.firstObject + 1 }; idx < node.firstObject + node.nrOfObjects; ++idx)
+			{
+				node.box = BoundingBox::Union(node.box, m_Boxes[m_Objects[idx]]);
+			}
+		}
+	}
+}
@@ -0,0 +1,153 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "Frustum.h"
+
+namespace dae
+{
+	//axis aligned box in world space
+	struct BoundingBox
+	{
+		Vector3 min{};
+		Vector3 max{};
+
+		Vector3 GetCenter() const { return (min + max) * 0.5f; }
+
+		//box around a box transformed by m, grows with the rotation but never misses a corner
+		static BoundingBox Transform(const Vector3& min, const Vector3& max, const Matrix& m);
+
+		static BoundingBox Union(const BoundingBox& a, const BoundingBox& b)
+		{
+			return BoundingBox
+			{
+				Vector3{ std::min(a.min.x, b.min.x), std::min(a.min.y, b.min.y), std::min(a.min.z, b.min.z) },
+				Vector3{ std::max(a.max.x, b.max.x), std::max(a.max.y, b.max.y), std::max(a.max.z, b.max.z) }
+			};
+		}
+	};
+
+	//bounding volume hierarchy over the boxes of the objects of a scene
+	//built when objects are added or removed, refit when they only move
+	class SceneBvh final
+	{
+	public:
+
+		struct QueryStatistics
+		{
+			uint32_t frustumCulled{};
+			uint32_t occluded{};
+		};
+
+		//splits the objects at the median of their centers on the longest axis until a leaf holds m_MaxLeafSize or less
+		void Build(std::span<const BoundingBox> boxes);
+
+		//keeps the tree and recomputes the boxes of the nodes bottom up, boxes has to hold the same objects as the last Build
+		void Refit(std::span<const BoundingBox> boxes);
+
+		//calls visit(object) for every object whose box is inside the frustum and not occluded
+		//isOccluded(box) is asked for every node inside the frustum, an occluded node skips all of its objects
+		template<typename IsOccluded, typename Visit>
+		QueryStatistics Query(const Frustum& frustum, IsOccluded isOccluded, Visit visit) const;
+
+	private:
+
+		static constexpr uint32_t m_MaxLeafSize{ 4 };
+
+		struct Node
+		{
+			BoundingBox box{};
+
+			//the objects of the subtree are a range of m_Objects
+			uint32_t firstObject{};
+			uint32_t nrOfObjects{};
+
+			//the right child follows the left one, 0 for a leaf (the root is never a child)
+			uint32_t leftChild{};
+		};
+
+		//children are always stored after their parent, refitting walks the nodes backwards
+		std::vector<Node> m_Nodes{};
+
+		//object indices sorted by leaf
+		std::vector<uint32_t> m_Objects{};
+		std::vector<BoundingBox> m_Boxes{};
+
+		void Split(uint32_t nodeIndex);
+	};
+
+	template<typename IsOccluded, typename Visit>
+	SceneBvh::QueryStatistics SceneBvh::Query(const Frustum& frustum, IsOccluded isOccluded, Visit visit) const
+	{
+		QueryStatistics statistics{};
+
+		if (m_Nodes.empty()) return statistics;
+
+		//node and whether its box is completely inside the frustum, the planes are not tested below such a node
+		struct Entry
+		{
+			uint32_t node;
+			bool isInside;
+		};
+
+		Entry stack[64]{};
+		uint32_t stackSize{};
+
+		stack[stackSize++] = { 0, false };
+
+		while (stackSize > 0)
+		{
+			const Entry entry{ stack[--stackSize] };
+			const Node& node{ m_Nodes[entry.node] };
+
+			bool isInside{ entry.isInside };
+
+			if (!isInside)
+			{
+				if (frustum.IsBoxOutside(node.box.min, node.box.max))
+				{
+					statistics.frustumCulled += node.nrOfObjects;
+					continue;
+				}
+
+				isInside = frustum.IsBoxInside(node.box.min, node.box.max);
+			}
+
+			if (isOccluded(node.box))
+			{
+				statistics.occluded += node.nrOfObjects;
+				continue;
+			}
+
+			if (node.leftChild != 0 && stackSize + 2 <= std::size(stack))
+			{
+				stack[stackSize++] = { node.leftChild + 1, isInside };
+				stack[stackSize++] = { node.leftChild, isInside };
+				continue;
+			}
+
+			//leaf, or a stack that is too deep for the tree, test the objects one by one
+			for (uint32_t idx{ node.firstObject }; idx < node.firstObject + node.nrOfObjects; ++idx)
+			{
+				const uint32_t object{ m_Objects[idx] };
+				const BoundingBox& box{ m_Boxes[object] };
+
+				if (!isInside && frustum.IsBoxOutside(box.min, box.max))
+				{
+					++statistics.frustumCulled;
+					continue;
+				}
+
+				if (node.nrOfObjects > 1 && isOccluded(box))
+				{
+					++statistics.occluded;
+					continue;
+				}
+
+				visit(object);
+			}
+		}
+
+		return statistics;
+	}
+}
@@ -1,13 +1,44 @@
 #include "pch.h"
 #include "Texture.h"
+#include "TextureCache.h"
 #include <SDL_image.h>
+#include <atomic>
+#include <bit>
 
 
 
 namespace dae
 {
-	Texture::Texture(SDL_Surface* pSurface, ID3D11Device* pDevice)
+	namespace
 	{
+		//small per thread cache of decoded blocks, neighbouring pixels mostly hit the same block
+		//entries are tagged with the texture id and the block index, a block address can be reused once its texture is evicted
+		struct DecodedBlock
+		{
+			uint32_t textureId{};
+			uint32_t blockIndex{};
+			uint32_t texels[16]{};
+		};
+
+		//4x4 blocks per texture, 8 textures
+		constexpr uint32_t blockCacheTileSize{ 4 };
+		constexpr uint32_t blockCacheTextures{ 8 };
+
+		thread_local DecodedBlock t_BlockCache[blockCacheTileSize * blockCacheTileSize * blockCacheTextures]{};
+
+		//0 marks an empty cache entry
+		std::atomic<uint32_t> g_NextTextureId{ 1 };
+	}
+
+	Texture::Texture(SDL_Surface* pSurface, ID3D11Device* pDevice, const void* pMappedView)
+		: m_pMappedView{ pMappedView }
+	{
+		//software only texture (baked on the cpu), no D3D resource
+		if (pDevice == nullptr)
+		{
+			InitializeSurface(pSurface);
+			return;
+		}
 
 		DXGI_FORMAT format = DXGI_FORMAT_R8G8B8A8_UNORM;
 		D3D11_TEXTURE2D_DESC desc{};
@@ -41,14 +72,55 @@ namespace dae
 
 		hr = pDevice->CreateShaderResourceView(m_pResource, &SRVDesc, &m_pSRV);
 
+		InitializeSurface(pSurface);
+
+		//SDL_FreeSurface(pSurface);
+
+	}
+
+	void Texture::InitializeSurface(SDL_Surface* pSurface)
+	{
 		m_pSurface = pSurface;
 
+		m_Width = pSurface->w;
+		m_Height = pSurface->h;
+
+		m_IsPowerOfTwo = std::has_single_bit(static_cast<uint32_t>(m_Width)) && std::has_single_bit(static_cast<uint32_t>(m_Height));
+		m_MaskX = m_Width - 1;
+		m_MaskY = m_Height - 1;
+		m_ShiftX = std::countr_zero(static_cast<uint32_t>(m_Width));
+		m_ShiftY = std::countr_zero(static_cast<uint32_t>(m_Height));
+
 		m_pSurfacePixels = static_cast<uint32_t*>(pSurface->pixels);
+	}
 
-		//SDL_FreeSurface(pSurface);
+	ColorRGB Texture::Sample(const Vector2& uv) const
+	{
+		switch (m_AddressMode)
+		{
+		case AddressMode::Clamp:
+			return Sample<AddressMode::Clamp>(uv);
+		case AddressMode::Mirror:
+			return Sample<AddressMode::Mirror>(uv);
+		default:
+			return Sample<AddressMode::Wrap>(uv);
+		}
+	}
 
+	Vector3 Texture::SampleVector3(const Vector2& uv) const
+	{
+		switch (m_AddressMode)
+		{
+		case AddressMode::Clamp:
+			return SampleVector3<AddressMode::Clamp>(uv);
+		case AddressMode::Mirror:
+			return SampleVector3<AddressMode::Mirror>(uv);
+		default:
+			return SampleVector3<AddressMode::Wrap>(uv);
+		}
 	}
 
+	template<Texture::AddressMode mode>
 	ColorRGB Texture::Sample(const Vector2& uv) const
 	{
 		// The rgb values in [0, 255] range
@@ -56,15 +128,8 @@ namespace dae
 		Uint8 g{};
 		Uint8 b{};
 
-		// Calculate the UV coordinates using clamp adressing mode
-		const int x{ static_cast<int>(std::clamp(uv.x, 0.0f, 1.0f) * static_cast<float>(m_pSurface->w)) };
-		const int y{ static_cast<int>(std::clamp(uv.y, 0.0f, 1.0f) * static_cast<float>(m_pSurface->h)) };
-
-		// Calculate the current pixelIdx on the texture
-		const Uint32 pixelIdx{ m_pSurfacePixels[x + y * m_pSurface->w] };
-
 		// Get the r g b values from the current pixel on the texture
-		SDL_GetRGB(pixelIdx, m_pSurface->format, &r, &g, &b);
+		GetTexelRGB<mode>(uv, r, g, b);
 
 		// The max value of a color attribute
 		constexpr float maxColorValue{ 255.0f };
@@ -74,17 +139,13 @@ namespace dae
 
 	}
 
+	template<Texture::AddressMode mode>
 	Vector3 Texture::SampleVector3(const Vector2& uv) const
 	{
 
 		Uint8 r{}, g{}, b{};
 
-		const size_t sampleX{ static_cast<size_t>(uv.x * static_cast<float>(m_pSurface->w)) };
-		const size_t sampleY{ static_cast<size_t>(uv.y * static_cast<float>(m_pSurface->h)) };
-
-		const Uint32 pixelIndex{ m_pSurfacePixels[sampleX + sampleY * m_pSurface->w] };
-
-		SDL_GetRGB(pixelIndex, m_pSurface->format, &r, &g, &b);
+		GetTexelRGB<mode>(uv, r, g, b);
 
 		const constexpr float invMax{ 1 / 255.f };
 
@@ -92,6 +153,138 @@ namespace dae
 
 	}
 
+	template ColorRGB Texture::Sample<Texture::AddressMode::Wrap>(const Vector2& uv) const;
+	template ColorRGB Texture::Sample<Texture::AddressMode::Clamp>(const Vector2& uv) const;
+	template ColorRGB Texture::Sample<Texture::AddressMode::Mirror>(const Vector2& uv) const;
+
+	template Vector3 Texture::SampleVector3<Texture::AddressMode::Wrap>(const Vector2& uv) const;
+	template Vector3 Texture::SampleVector3<Texture::AddressMode::Clamp>(const Vector2& uv) const;
+	template Vector3 Texture::SampleVector3<Texture::AddressMode::Mirror>(const Vector2& uv) const;
+
+	template<Texture::AddressMode mode, bool isPowerOfTwo>
+	int Texture::AddressTexel(int coord, int size, int mask, int shift)
+	{
+		if constexpr (mode == AddressMode::Clamp)
+		{
+			return std::clamp(coord, 0, size - 1);
+		}
+		else if constexpr (mode == AddressMode::Wrap && isPowerOfTwo)
+		{
+			//two's complement makes the mask wrap negative coordinates too
+			return coord & mask;
+		}
+		else if constexpr (mode == AddressMode::Wrap)
+		{
+			return ((coord % size) + size) % size;
+		}
+		else if constexpr (isPowerOfTwo)
+		{
+			//position in the mirrored period [0, 2 * size), the second half is flipped by inverting the bits
+			const int period{ coord & ((mask << 1) | 1) };
+			const int flip{ -(period >> shift) };
+			return (period ^ flip) & mask;
+		}
+		else
+		{
+			const int period{ ((coord % (size * 2)) + size * 2) % (size * 2) };
+			return std::min(period, size * 2 - 1 - period);
+		}
+	}
+
+	template<Texture::AddressMode mode>
+	void Texture::GetTexelRGB(const Vector2& uv, Uint8& r, Uint8& g, Uint8& b) const
+	{
+		const int u{ static_cast<int>(std::floor(uv.x * static_cast<float>(m_Width))) };
+		const int v{ static_cast<int>(std::floor(uv.y * static_cast<float>(m_Height))) };
+
+		// Calculate the texel using the addressing mode of the draw, the size of the texture never changes so the branch is always predicted
+		const int x{ m_IsPowerOfTwo ? AddressTexel<mode, true>(u, m_Width, m_MaskX, m_ShiftX) : AddressTexel<mode, false>(u, m_Width, m_MaskX, m_ShiftX) };
+		const int y{ m_IsPowerOfTwo ? AddressTexel<mode, true>(v, m_Height, m_MaskY, m_ShiftY) : AddressTexel<mode, false>(v, m_Height, m_MaskY, m_ShiftY) };
+
+		if (m_Format == TextureFormat::RGBA8)
+		{
+			// Calculate the current pixelIdx on the texture
+			const Uint32 pixelIdx{ m_pSurfacePixels[x + y * m_Width] };
+
+			SDL_GetRGB(pixelIdx, m_pSurface->format, &r, &g, &b);
+			return;
+		}
+
+		constexpr int blockSize{ BlockCompression::BlockSize };
+
+		const int blockX{ x / blockSize };
+		const int blockY{ y / blockSize };
+
+		const uint32_t blockIndex{ static_cast<uint32_t>(blockX + blockY * m_BlocksPerRow) };
+
+		//look the block up in the decoded block cache, decode it on a miss
+		const uint32_t cacheIdx
+		{
+			(static_cast<uint32_t>(blockX) % blockCacheTileSize) +
+			(static_cast<uint32_t>(blockY) % blockCacheTileSize) * blockCacheTileSize +
+			(m_TextureId % blockCacheTextures) * blockCacheTileSize * blockCacheTileSize
+		};
+
+		DecodedBlock& decoded{ t_BlockCache[cacheIdx] };
+
+		if (decoded.textureId != m_TextureId || decoded.blockIndex != blockIndex)
+		{
+			BlockCompression::DecodeBlock(m_Format, &m_Blocks[static_cast<size_t>(blockIndex) * BlockCompression::GetBlockBytes(m_Format)], decoded.texels);
+			decoded.textureId = m_TextureId;
+			decoded.blockIndex = blockIndex;
+		}
+
+		//decoded texels are RGBA8 with r in the lowest byte
+		const uint32_t texel{ decoded.texels[(x % blockSize) + (y % blockSize) * blockSize] };
+
+		r = static_cast<Uint8>(texel);
+		g = static_cast<Uint8>(texel >> 8);
+		b = static_cast<Uint8>(texel >> 16);
+	}
+
+	void Texture::Compress(TextureFormat format)
+	{
+		if (m_pSurface == nullptr || format == TextureFormat::RGBA8 || m_Format != TextureFormat::RGBA8) return;
+
+		//the encoder expects r in the lowest byte, cached textures already are in that layout
+		SDL_Surface* pSource{ m_pSurface };
+
+		if (m_pSurface->format->format != SDL_PIXELFORMAT_ABGR8888)
+		{
+			pSource = SDL_ConvertSurfaceFormat(m_pSurface, SDL_PIXELFORMAT_ABGR8888, 0);
+
+			if (pSource == nullptr) return;
+		}
+
+		m_Blocks = BlockCompression::Encode(format, static_cast<const uint32_t*>(pSource->pixels), m_Width, m_Height, pSource->pitch / 4);
+		m_BlocksPerRow = (m_Width + BlockCompression::BlockSize - 1) / BlockCompression::BlockSize;
+		m_TextureId = g_NextTextureId++;
+		m_Format = format;
+
+		if (pSource != m_pSurface) SDL_FreeSurface(pSource);
+
+		//the uncompressed pixels are not needed anymore
+		SDL_FreeSurface(m_pSurface);
+		TextureCache::Release(m_pMappedView);
+
+		m_pSurface = nullptr;
+		m_pSurfacePixels = nullptr;
+		m_pMappedView = nullptr;
+	}
+
+	size_t Texture::GetMemorySize() const
+	{
+		if (m_Format != TextureFormat::RGBA8) return m_Blocks.size();
+
+		return m_pSurface ? static_cast<size_t>(m_pSurface->pitch) * m_Height : 0;
+	}
+
+	size_t Texture::GetGPUMemorySize() const
+	{
+		//R8G8B8A8, single mip
+		return m_pResource ? static_cast<size_t>(m_Width) * m_Height * 4 : 0;
+	}
+
 	Texture::~Texture()
 	{
 
@@ -99,11 +292,21 @@ namespace dae
 		if (m_pResource) m_pResource->Release();
 
 		SDL_FreeSurface(m_pSurface);
+
+		//unmap after the surface is gone, it points into the view
+		TextureCache::Release(m_pMappedView);
 	}
 
 	Texture* Texture::LoadFromFile(const std::string& path, ID3D11Device* pDevice)
 	{
-		return new Texture{ IMG_Load(path.c_str()), pDevice };
+		const DecodedTexture decoded{ TextureCache::Decode(path) };
+
+		return LoadFromSurface(decoded.pSurface, pDevice, decoded.pMappedView);
+	}
+
+	Texture* Texture::LoadFromSurface(SDL_Surface* pSurface, ID3D11Device* pDevice, const void* pMappedView)
+	{
+		return new Texture{ pSurface, pDevice, pMappedView };
 	}
 
 }
\ No newline at end of file
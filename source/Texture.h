@@ -1,6 +1,8 @@
 #pragma once
 #include <SDL_surface.h>
 #include <string>
+#include <vector>
+#include "BlockCompression.h"
 //#include "ColorRGB.h"
 //#include "Vector3.h"
 
@@ -11,25 +13,96 @@ namespace dae
 	class Texture
 	{
 	public:
+
+		//how uvs outside [0, 1] are mapped back onto the texture (software rasterizer)
+		enum class AddressMode
+		{
+			Wrap,
+			Clamp,
+			Mirror
+		};
+
 		~Texture();
 
 		static Texture* LoadFromFile(const std::string& path, ID3D11Device* pDevice);
 
+		//takes ownership of an already decoded surface (used by the TextureLoader)
+		//pMappedView is the cache file the pixels live in, it is released with the texture
+		//without a device only the software copy is created
+		static Texture* LoadFromSurface(SDL_Surface* pSurface, ID3D11Device* pDevice, const void* pMappedView = nullptr);
+
 		ID3D11ShaderResourceView* GetSRV() const { return m_pSRV; }
 
+		int GetWidth() const { return m_Width; }
+		int GetHeight() const { return m_Height; }
+
 		// Software Rasterizer
+		//addresses with the mode of the texture
 		ColorRGB Sample(const Vector2& uv) const;
 
 		Vector3 SampleVector3(const Vector2& uv) const;
 
+		//the mode is picked once per draw, the fetch is instantiated for it
+		template<AddressMode mode>
+		ColorRGB Sample(const Vector2& uv) const;
+
+		template<AddressMode mode>
+		Vector3 SampleVector3(const Vector2& uv) const;
+
+		void SetAddressMode(AddressMode mode) { m_AddressMode = mode; }
+		AddressMode GetAddressMode() const { return m_AddressMode; }
+
+		//re-encodes the software copy into 4x4 blocks and frees the uncompressed pixels
+		//the D3D texture is not affected
+		void Compress(TextureFormat format);
+
+		//bytes used by the software copy
+		size_t GetMemorySize() const;
+
+		//bytes used by the D3D texture
+		size_t GetGPUMemorySize() const;
+
 	private:
 
-		Texture(SDL_Surface* pSurface, ID3D11Device* pDevice);
+		Texture(SDL_Surface* pSurface, ID3D11Device* pDevice, const void* pMappedView);
+
+		void InitializeSurface(SDL_Surface* pSurface);
 
 		// Software Rasterizer
 		SDL_Surface* m_pSurface{ nullptr };
 		uint32_t* m_pSurfacePixels{ nullptr };
 
+		//mapped cache file backing the surface pixels (zero-copy path)
+		const void* m_pMappedView{ nullptr };
+
+		int m_Width{};
+		int m_Height{};
+
+		//size - 1 and log2 of the size per axis, only used when both sizes are a power of two
+		bool m_IsPowerOfTwo{};
+		int m_MaskX{};
+		int m_MaskY{};
+		int m_ShiftX{};
+		int m_ShiftY{};
+
+		//wrap matches the samplers of the effects
+		AddressMode m_AddressMode{ AddressMode::Wrap };
+
+		template<AddressMode mode, bool isPowerOfTwo>
+		static int AddressTexel(int coord, int size, int mask, int shift);
+
+		//compressed software copy, blocks are decoded on the fly while sampling
+		TextureFormat m_Format{ TextureFormat::RGBA8 };
+		std::vector<uint8_t> m_Blocks{};
+		int m_BlocksPerRow{};
+
+		//unique per compressed texture, tags its entries in the decoded block cache
+		uint32_t m_TextureId{};
+
+		//uv to texel, addresses the coordinates so the fetch is always inside the texture
+		template<AddressMode mode>
+		void GetTexelRGB(const Vector2& uv, Uint8& r, Uint8& g, Uint8& b) const;
+
 		//hardware Rasterizer
 		ID3D11Texture2D* m_pResource{};
 		ID3D11ShaderResourceView* m_pSRV{};
@@ -0,0 +1,155 @@
+#include "pch.h"
+#include "TextureCache.h"
+#include "Windows.h"
+#include <filesystem>
+#include <fstream>
+
+namespace dae
+{
+	DecodedTexture TextureCache::Decode(const std::string& sourcePath)
+	{
+		std::error_code error{};
+
+		//key of the cache entry: path, size and last write time of the source
+		Header header{};
+		header.magic = m_Magic;
+		header.version = m_Version;
+		header.sourceSize = std::filesystem::file_size(sourcePath, error);
+		header.sourceTime = std::filesystem::last_write_time(sourcePath, error).time_since_epoch().count();
+		header.pixelFormat = m_PixelFormat;
+		header.pixelOffset = m_PixelOffset;
+
+		const std::string cachePath{ GetCachePath(sourcePath) };
+
+		if (!error)
+		{
+			if (const DecodedTexture cached{ Load(cachePath, header) }; cached.pSurface != nullptr)
+			{
+				++m_Hits;
+				return cached;
+			}
+		}
+
+		++m_Misses;
+
+		//cold path, decode the png and convert it to the format the texture is created with
+		SDL_Surface* pLoaded{ IMG_Load(sourcePath.c_str()) };
+
+		if (pLoaded == nullptr) return {};
+
+		SDL_Surface* pSurface{ SDL_ConvertSurfaceFormat(pLoaded, m_PixelFormat, 0) };
+
+		SDL_FreeSurface(pLoaded);
+
+		if (pSurface == nullptr || error) return { pSurface };
+
+		header.width = static_cast<uint32_t>(pSurface->w);
+		header.height = static_cast<uint32_t>(pSurface->h);
+		header.pitch = static_cast<uint32_t>(pSurface->pitch);
+
+		Store(cachePath, header, pSurface);
+
+		return { pSurface };
+	}
+
+	void TextureCache::Release(const void* pMappedView)
+	{
+		if (pMappedView) UnmapViewOfFile(pMappedView);
+	}
+
+	std::string TextureCache::GetCachePath(const std::string& sourcePath)
+	{
+		//flatten the source path into a single file name inside the cache folder
+		std::string fileName{ sourcePath };
+		std::replace(fileName.begin(), fileName.end(), '/', '_');
+		std::replace(fileName.begin(), fileName.end(), '\\', '_');
+
+		return "Resources/Cache/" + fileName + ".tex";
+	}
+
+	DecodedTexture TextureCache::Load(const std::string& cachePath, const Header& expected)
+	{
+		const HANDLE file{ CreateFileA(cachePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr) };
+
+		if (file == INVALID_HANDLE_VALUE) return {};
+
+		LARGE_INTEGER fileSize{};
+		GetFileSizeEx(file, &fileSize);
+
+		if (static_cast<uint64_t>(fileSize.QuadPart) < m_PixelOffset)
+		{
+			CloseHandle(file);
+			return {};
+		}
+
+		const HANDLE mapping{ CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) };
+
+		CloseHandle(file);
+
+		if (mapping == nullptr) return {};
+
+		//the view keeps the file alive, the handles are not needed anymore
+		const void* pView{ MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) };
+
+		CloseHandle(mapping);
+
+		if (pView == nullptr) return {};
+
+		const Header& header{ *static_cast<const Header*>(pView) };
+
+		const bool isValid
+		{
+			header.magic == expected.magic &&
+			header.version == expected.version &&
+			header.sourceSize == expected.sourceSize &&
+			header.sourceTime == expected.sourceTime &&
+			header.pixelFormat == expected.pixelFormat &&
+			header.pixelOffset == expected.pixelOffset &&
+			static_cast<uint64_t>(fileSize.QuadPart) >= uint64_t{ header.pixelOffset } + uint64_t{ header.pitch } * header.height
+		};
+
+		if (!isValid)
+		{
+			UnmapViewOfFile(pView);
+			return {};
+		}
+
+		//the surface points straight into the mapped file, SDL_FreeSurface leaves the pixels alone
+		void* pPixels{ const_cast<uint8_t*>(static_cast<const uint8_t*>(pView) + header.pixelOffset) };
+
+		SDL_Surface* pSurface{ SDL_CreateRGBSurfaceWithFormatFrom(pPixels, static_cast<int>(header.width), static_cast<int>(header.height), 32, static_cast<int>(header.pitch), header.pixelFormat) };
+
+		if (pSurface == nullptr)
+		{
+			UnmapViewOfFile(pView);
+			return {};
+		}
+
+		return { pSurface, pView };
+	}
+
+	void TextureCache::Store(const std::string& cachePath, const Header& header, const SDL_Surface* pSurface)
+	{
+		std::error_code error{};
+		std::filesystem::create_directories(std::filesystem::path{ cachePath }.parent_path(), error);
+
+		//write to a temporary file first so a concurrent or interrupted run never sees half a file
+		const std::string tempPath{ cachePath + ".tmp" };
+
+		{
+			std::ofstream file{ tempPath, std::ios::binary | std::ios::trunc };
+
+			if (!file) return;
+
+			char padding[m_PixelOffset]{};
+
+			file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+			file.write(padding, m_PixelOffset - sizeof(Header));
+			file.write(static_cast<const char*>(pSurface->pixels), static_cast<std::streamsize>(header.pitch) * header.height);
+
+			if (!file) return;
+		}
+
+		std::filesystem::rename(tempPath, cachePath, error);
+	}
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace dae
+{
+	//result of a decode, pMappedView is set when the pixels live in a mapped cache file
+	struct DecodedTexture
+	{
+		SDL_Surface* pSurface{ nullptr };
+		const void* pMappedView{ nullptr };
+	};
+
+	//stores decoded and converted textures in a binary file next to the resources
+	//a warm cache is memory mapped and handed out without copying the pixels
+	class TextureCache final
+	{
+	public:
+
+		//returns the texture from the cache when it is still valid, decodes and stores it otherwise
+		//safe to call from the TextureLoader worker threads
+		static DecodedTexture Decode(const std::string& sourcePath);
+
+		//unmaps a view that was handed out by Decode
+		static void Release(const void* pMappedView);
+
+		static uint32_t GetHits() { return m_Hits; }
+		static uint32_t GetMisses() { return m_Misses; }
+
+	private:
+
+		struct Header
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint64_t sourceSize;
+			int64_t sourceTime;
+			uint32_t width;
+			uint32_t height;
+			uint32_t pitch;
+			uint32_t pixelFormat;
+			uint32_t pixelOffset;
+		};
+
+		static constexpr uint32_t m_Magic{ 0x58455444 }; // "DTEX"
+		static constexpr uint32_t m_Version{ 1 };
+
+		//pixels start on a cache line
+		static constexpr uint32_t m_PixelOffset{ 64 };
+		static_assert(sizeof(Header) <= m_PixelOffset);
+
+		//the format the D3D texture is created with (R8G8B8A8 in memory)
+		static constexpr uint32_t m_PixelFormat{ SDL_PIXELFORMAT_ABGR8888 };
+
+		static inline std::atomic<uint32_t> m_Hits{};
+		static inline std::atomic<uint32_t> m_Misses{};
+
+		static std::string GetCachePath(const std::string& sourcePath);
+
+		static DecodedTexture Load(const std::string& cachePath, const Header& expected);
+
+		static void Store(const std::string& cachePath, const Header& header, const SDL_Surface* pSurface);
+	};
+}
@@ -0,0 +1,55 @@
+#include "pch.h"
+#include "TextureLoader.h"
+#include "Texture.h"
+
+namespace dae
+{
+	TextureLoader::TextureLoader()
+	{
+		//IMG_Load initializes the png decoder lazily, do it once here so the workers don't race on it
+		IMG_Init(IMG_INIT_PNG);
+	}
+
+	TextureLoader::~TextureLoader()
+	{
+		//free the surfaces that were requested but never picked up
+		for (auto& [path, pPending] : m_PendingTextures)
+		{
+			JobSystem::Wait(pPending->job);
+
+			SDL_FreeSurface(pPending->decoded.pSurface);
+			TextureCache::Release(pPending->decoded.pMappedView);
+		}
+	}
+
+	void TextureLoader::Request(const std::string& path)
+	{
+		if (m_PendingTextures.contains(path)) return;
+
+		//the map only holds pointers, the job keeps writing to the same texture when the map grows
+		PendingTexture* pPending{ m_PendingTextures.emplace(path, std::make_unique<PendingTexture>()).first->second.get() };
+
+		JobSystem::Run(pPending->job, [pPending, path]()
+		{
+			pPending->decoded = TextureCache::Decode(path);
+		}, "texture decode");
+	}
+
+	Texture* TextureLoader::Get(const std::string& path, ID3D11Device* pDevice)
+	{
+		//not requested up front, decode it on this thread
+		const auto it{ m_PendingTextures.find(path) };
+
+		if (it == m_PendingTextures.end()) return Texture::LoadFromFile(path, pDevice);
+
+		//helps with the other queued jobs while the decode is still running
+		JobSystem::Wait(it->second->job);
+
+		const DecodedTexture decoded{ it->second->decoded };
+
+		m_PendingTextures.erase(it);
+
+		//the resource creation stays on the calling thread
+		return Texture::LoadFromSurface(decoded.pSurface, pDevice, decoded.pMappedView);
+	}
+}
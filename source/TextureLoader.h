@@ -0,0 +1,42 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include "JobSystem.h"
+#include "TextureCache.h"
+
+namespace dae
+{
+	class Texture;
+
+	//decodes textures in jobs so the png decoding overlaps with the rest of the loading
+	class TextureLoader final
+	{
+	public:
+
+		TextureLoader();
+		~TextureLoader();
+
+		TextureLoader(const TextureLoader&) = delete;
+		TextureLoader(TextureLoader&&) noexcept = delete;
+		TextureLoader& operator=(const TextureLoader&) = delete;
+		TextureLoader& operator=(TextureLoader&&) noexcept = delete;
+
+		//queues the decode of the file, returns immediately
+		void Request(const std::string& path);
+
+		//waits for the decode of the file to finish and creates the texture from it
+		Texture* Get(const std::string& path, ID3D11Device* pDevice);
+
+	private:
+
+		//written by the decode job, read once its counter is done
+		struct PendingTexture
+		{
+			DecodedTexture decoded{};
+			JobCounter job{};
+		};
+
+		std::unordered_map<std::string, std::unique_ptr<PendingTexture>> m_PendingTextures{};
+	};
+}
@@ -1,36 +1,139 @@
 #pragma once
+#include <cassert>
+#include <cmath>
+#include <type_traits>
+#include <xmmintrin.h>
+#include "Vector2.h"
+#include "Vector3.h"
 
 namespace dae
 {
-	struct Vector2;
-	struct Vector3;
-	struct Vector4
+	//16 byte aligned so a row can be loaded straight into an sse register
+	struct alignas(16) Vector4
 	{
 		float x;
 		float y;
 		float z;
 		float w;
 
-		Vector4() = default;
-		Vector4(float _x, float _y, float _z, float _w);
-		Vector4(const Vector3& v, float _w);
+		constexpr Vector4() = default;
+		constexpr Vector4(float _x, float _y, float _z, float _w) : x(_x), y(_y), z(_z), w(_w) {}
+		constexpr Vector4(const Vector3& v, float _w) : x(v.x), y(v.y), z(v.z), w(_w) {}
 
 		float Magnitude() const;
-		float SqrMagnitude() const;
+		constexpr float SqrMagnitude() const;
 		float Normalize();
 		Vector4 Normalized() const;
 
-		Vector2 GetXY() const;
-		Vector3 GetXYZ() const;
+		constexpr Vector2 GetXY() const;
+		constexpr Vector3 GetXYZ() const;
 
-		static float Dot(const Vector4& v1, const Vector4& v2);
+		static constexpr float Dot(const Vector4& v1, const Vector4& v2);
 
 		// operator overloading
-		Vector4 operator*(float scale) const;
-		Vector4 operator+(const Vector4& v) const;
-		Vector4 operator-(const Vector4& v) const;
-		Vector4& operator+=(const Vector4& v);
-		float& operator[](int index);
-		float operator[](int index) const;
+		constexpr Vector4 operator*(float scale) const;
+		constexpr Vector4 operator+(const Vector4& v) const;
+		constexpr Vector4 operator-(const Vector4& v) const;
+		constexpr Vector4& operator+=(const Vector4& v);
+		constexpr float& operator[](int index);
+		constexpr float operator[](int index) const;
+
+		//sse access
+		__m128 Load() const { return _mm_load_ps(&x); }
+		void Store(__m128 v) { _mm_store_ps(&x, v); }
+		static Vector4 FromSSE(__m128 v)
+		{
+			Vector4 result;
+			result.Store(v);
+			return result;
+		}
 	};
+
+	//conversions of Vector3 that need the full Vector4
+	constexpr Vector3::Vector3(const Vector4& v) : x(v.x), y(v.y), z(v.z) {}
+
+	constexpr Vector4 Vector3::ToPoint4() const
+	{
+		return { x, y, z, 1 };
+	}
+
+	constexpr Vector4 Vector3::ToVector4() const
+	{
+		return { x, y, z, 0 };
+	}
+
+	inline float Vector4::Magnitude() const
+	{
+		return sqrtf(SqrMagnitude());
+	}
+
+	constexpr float Vector4::SqrMagnitude() const
+	{
+		return Dot(*this, *this);
+	}
+
+	constexpr Vector2 Vector4::GetXY() const
+	{
+		return { x, y };
+	}
+
+	constexpr Vector3 Vector4::GetXYZ() const
+	{
+		return { x, y, z };
+	}
+
+	constexpr float Vector4::Dot(const Vector4& v1, const Vector4& v2)
+	{
+		return v1.x * v2.x + v1.y * v2.y + v1.z * v2.z + v1.w * v2.w;
+	}
+
+#pragma region Operator Overloads
+	//the sse versions cannot run at compile time, constant expressions take the scalar path
+	constexpr Vector4 Vector4::operator*(float scale) const
+	{
+		if (std::is_constant_evaluated()) return { x * scale, y * scale, z * scale, w * scale };
+
+		return FromSSE(_mm_mul_ps(Load(), _mm_set1_ps(scale)));
+	}
+
+	constexpr Vector4 Vector4::operator+(const Vector4& v) const
+	{
+		if (std::is_constant_evaluated()) return { x + v.x, y + v.y, z + v.z, w + v.w };
+
+		return FromSSE(_mm_add_ps(Load(), v.Load()));
+	}
+
+	constexpr Vector4 Vector4::operator-(const Vector4& v) const
+	{
+		if (std::is_constant_evaluated()) return { x - v.x, y - v.y, z - v.z, w - v.w };
+
+		return FromSSE(_mm_sub_ps(Load(), v.Load()));
+	}
+
+	constexpr Vector4& Vector4::operator+=(const Vector4& v)
+	{
+		*this = *this + v;
+		return *this;
+	}
+
+	constexpr float& Vector4::operator[](int index)
+	{
+		assert(index <= 3 && index >= 0);
+
+		if (index == 0) return x;
+		if (index == 1) return y;
+		if (index == 2) return z;
+		return w;
+	}
+
+	constexpr float Vector4::operator[](int index) const
+	{
+		assert(index <= 3 && index >= 0);
+
+		if (index == 0) return x;
+		if (index == 1) return y;
+		if (index == 2) return z;
+		return w;
+	}
+#pragma endregion
 }
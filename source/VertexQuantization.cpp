@@ -0,0 +1,131 @@
+#include "pch.h"
+#include "VertexQuantization.h"
+
+namespace dae
+{
+	namespace VertexQuantization
+	{
+		namespace
+		{
+			uint16_t FloatToUnorm16(float value)
+			{
+				return static_cast<uint16_t>(std::lround(std::clamp(value, 0.f, 1.f) * 65535.f));
+			}
+
+			int16_t FloatToSnorm16(float value)
+			{
+				return static_cast<int16_t>(std::lround(std::clamp(value, -1.f, 1.f) * 32767.f));
+			}
+		}
+
+		std::vector<PackedVertex> Pack(const std::vector<Vertex>& vertices, Bounds& bounds)
+		{
+			//calc the box of the positions
+			Vector3 minPosition{ FLT_MAX, FLT_MAX, FLT_MAX };
+			Vector3 maxPosition{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+			for (const Vertex& vertex : vertices)
+			{
+				minPosition = Vector3{ std::min(minPosition.x, vertex.position.x), std::min(minPosition.y, vertex.position.y), std::min(minPosition.z, vertex.position.z) };
+				maxPosition = Vector3{ std::max(maxPosition.x, vertex.position.x), std::max(maxPosition.y, vertex.position.y), std::max(maxPosition.z, vertex.position.z) };
+			}
+
+			if (vertices.empty()) minPosition = maxPosition = Vector3{};
+
+			bounds.min = minPosition;
+			bounds.extent = maxPosition - minPosition;
+
+			//flat axes would divide by zero, every position on them quantizes to 0
+			const Vector3 invExtent
+			{
+				bounds.extent.x > 0.f ? 1.f / bounds.extent.x : 0.f,
+				bounds.extent.y > 0.f ? 1.f / bounds.extent.y : 0.f,
+				bounds.extent.z > 0.f ? 1.f / bounds.extent.z : 0.f
+			};
+
+			std::vector<PackedVertex> packedVertices(vertices.size());
+
+			for (size_t idx{}; idx < vertices.size(); ++idx)
+			{
+				const Vertex& vertex{ vertices[idx] };
+				PackedVertex& packed{ packedVertices[idx] };
+
+				const Vector3 relativePosition{ vertex.position - bounds.min };
+
+				packed.position[0] = FloatToUnorm16(relativePosition.x * invExtent.x);
+				packed.position[1] = FloatToUnorm16(relativePosition.y * invExtent.y);
+				packed.position[2] = FloatToUnorm16(relativePosition.z * invExtent.z);
+
+				EncodeOctahedral(vertex.normal, packed.normal);
+				EncodeOctahedral(vertex.tangent, packed.tangent);
+
+				packed.uv[0] = FloatToHalf(vertex.uv.x);
+				packed.uv[1] = FloatToHalf(vertex.uv.y);
+			}
+
+			return packedVertices;
+		}
+
+		Matrix GetDequantizationMatrix(const Bounds& bounds)
+		{
+			return Matrix
+			{
+				Vector4{ bounds.extent.x, 0.f, 0.f, 0.f },
+				Vector4{ 0.f, bounds.extent.y, 0.f, 0.f },
+				Vector4{ 0.f, 0.f, bounds.extent.z, 0.f },
+				Vector4{ bounds.min.x, bounds.min.y, bounds.min.z, 1.f }
+			};
+		}
+
+		uint16_t FloatToHalf(float value)
+		{
+			const uint32_t bits{ std::bit_cast<uint32_t>(value) };
+			const uint16_t sign{ static_cast<uint16_t>((bits >> 16) & 0x8000u) };
+			const uint32_t magnitudeBits{ bits & 0x7FFFFFFFu };
+
+			//infinity and nan
+			if (magnitudeBits >= 0x7F800000u) return sign | 0x7C00u | (magnitudeBits > 0x7F800000u ? 0x200u : 0u);
+
+			//everything from 65520 up rounds to infinity
+			if (magnitudeBits >= 0x477FF000u) return sign | 0x7C00u;
+
+			//below the smallest normal half (2^-14), stored as a multiple of 2^-24
+			if (magnitudeBits < 0x38800000u)
+			{
+				return sign | static_cast<uint16_t>(std::lround(std::bit_cast<float>(magnitudeBits) * 16777216.f));
+			}
+
+			//round to nearest even on the 13 dropped mantissa bits, a carry moves into the exponent on purpose
+			const uint32_t rounded{ magnitudeBits + 0xFFFu + ((magnitudeBits >> 13) & 1u) };
+
+			//rebias the exponent from 127 to 15
+			return sign | static_cast<uint16_t>((rounded - 0x38000000u) >> 13);
+		}
+
+		void EncodeOctahedral(const Vector3& direction, int16_t encoded[2])
+		{
+			const float length{ std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z) };
+
+			if (length <= 0.f)
+			{
+				encoded[0] = encoded[1] = 0;
+				return;
+			}
+
+			//project on the octahedron
+			float x{ direction.x / length };
+			float y{ direction.y / length };
+
+			//fold the lower hemisphere over the diagonals
+			if (direction.z < 0.f)
+			{
+				const float foldedX{ (1.f - std::abs(y)) * (x >= 0.f ? 1.f : -1.f) };
+				y = (1.f - std::abs(x)) * (y >= 0.f ? 1.f : -1.f);
+				x = foldedX;
+			}
+
+			encoded[0] = FloatToSnorm16(x);
+			encoded[1] = FloatToSnorm16(y);
+		}
+	}
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "DataTypes.h"
+
+namespace dae
+{
+	//encoding and decoding of the PackedVertex attributes
+	//the decoders match what the D3D input assembler does with the formats of the input layout
+	namespace VertexQuantization
+	{
+		//box the positions are quantized against
+		struct Bounds
+		{
+			Vector3 min{};
+			Vector3 extent{};
+		};
+
+		//quantizes every vertex, bounds receives the box of the positions
+		std::vector<PackedVertex> Pack(const std::vector<Vertex>& vertices, Bounds& bounds);
+
+		//maps the [0, 1] unorm positions back into object space (scale by the extent, then translate by the min)
+		Matrix GetDequantizationMatrix(const Bounds& bounds);
+
+		uint16_t FloatToHalf(float value);
+
+		//octahedral encoding of a direction, the length of the vector does not matter
+		void EncodeOctahedral(const Vector3& direction, int16_t encoded[2]);
+
+		inline float HalfToFloat(uint16_t value)
+		{
+			const uint32_t sign{ static_cast<uint32_t>(value & 0x8000u) << 16 };
+			const uint32_t exponent{ (value >> 10) & 0x1Fu };
+			const uint32_t mantissa{ value & 0x3FFu };
+
+			//zero and subnormals
+			if (exponent == 0)
+			{
+				const float magnitude{ static_cast<float>(mantissa) * (1.f / 16777216.f) };
+				return sign ? -magnitude : magnitude;
+			}
+
+			//infinity and nan
+			if (exponent == 31) return std::bit_cast<float>(sign | 0x7F800000u | (mantissa << 13));
+
+			//rebias the exponent from 15 to 127
+			return std::bit_cast<float>(sign | ((exponent + 112) << 23) | (mantissa << 13));
+		}
+
+		inline Vector2 DecodeUV(const uint16_t uv[2])
+		{
+			return Vector2{ HalfToFloat(uv[0]), HalfToFloat(uv[1]) };
+		}
+
+		//snorm to float the way the input assembler does it, -32768 and -32767 both map to -1
+		inline float SnormToFloat(int16_t value)
+		{
+			return std::max(static_cast<float>(value) * (1.f / 32767.f), -1.f);
+		}
+
+		//the result is not normalized, it is normalized after being transformed
+		inline Vector3 DecodeOctahedral(const int16_t encoded[2])
+		{
+			Vector3 direction{ SnormToFloat(encoded[0]), SnormToFloat(encoded[1]), 0.f };
+			direction.z = 1.f - std::abs(direction.x) - std::abs(direction.y);
+
+			//unfold the lower hemisphere
+			const float fold{ std::max(-direction.z, 0.f) };
+			direction.x += direction.x >= 0.f ? -fold : fold;
+			direction.y += direction.y >= 0.f ? -fold : fold;
+
+			return direction;
+		}
+	}
+}
@@ -7,6 +7,7 @@
 
 #undef main
 #include "Renderer.h"
+#include "MathBenchmark.h"
 #include  <conio.h>
 
 using namespace dae;
@@ -19,10 +20,6 @@ void ShutDown(SDL_Window* pWindow)
 
 int main(int argc, char* args[])
 {
-	//Unreferenced parameters
-	(void)argc;
-	(void)args;
-
 	//code to let the color change work
 	DWORD consoleMode;
 
@@ -33,6 +30,13 @@ int main(int argc, char* args[])
 		SetConsoleMode(outputHandle, consoleMode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
 	}
 
+	//math microbenchmarks, no window needed
+	if (argc > 1 && std::string{ args[1] } == "-benchmark")
+	{
+		MathBenchmark::Run();
+		return 0;
+	}
+
 	//Create window + surfaces
 	SDL_Init(SDL_INIT_VIDEO);
 
@@ -102,6 +106,20 @@ int main(int argc, char* args[])
 
 				if (e.key.keysym.scancode == SDL_SCANCODE_F11) pRenderer->TogglePrintingFPS();
 
+				if (e.key.keysym.scancode == SDL_SCANCODE_F12) pRenderer->ToggleMathQuality();
+
+				if (e.key.keysym.scancode == SDL_SCANCODE_L) pRenderer->ToggleAutomaticLod();
+
+				if (e.key.keysym.scancode == SDL_SCANCODE_I) pRenderer->CycleInstanceGrid();
+
+				if (e.key.keysym.scancode == SDL_SCANCODE_O) pRenderer->ToggleOcclusionCulling();
+
+				if (e.key.keysym.scancode == SDL_SCANCODE_P) pRenderer->ToggleFrameMode();
+
+				if (e.key.keysym.scancode == SDL_SCANCODE_B) pRenderer->ToggleBackBuffers();
+
+				if (e.key.keysym.scancode == SDL_SCANCODE_M) pRenderer->TogglePresentMode();
+
 				break;
 
 			default: ;
@@ -128,6 +146,7 @@ int main(int argc, char* args[])
 				printTimer = 0.f;
 				std::cout << "\033[37m"; //print fps in white
 				std::cout << "dFPS: " << pTimer->GetdFPS() << std::endl;
+				pRenderer->PrintFrameStatistics();
 			}
 		}
 		